@@ -0,0 +1,129 @@
+/**
+ * @file cpu_governor.hpp
+ * @author Nq139 (fnq409997@gmail.com)
+ * @brief CPU 预算调节器，超出预算时按优先级逐级停用可选功能
+ * @copyright Copyright 2026, Nq139
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+
+#include "thread_placement.hpp"
+
+/**
+ * @brief CPU 预算调节器
+ * @details 每秒由心跳线程调用一次 `update()`，以进程 CPU 时间的增量估计占用率（单核的比例）并做指数平滑。
+ *          平滑后的占用率连续 3 次超出预算时提升一级降级等级，连续 10 次低于预算的 60% 时恢复一级。
+ *          降级只影响可选功能，节点与端点的发现、心跳广播与超时清理始终照常运行
+ */
+class CpuGovernor
+{
+public:
+    //! 降级等级，按顺序逐级停用可选功能
+    enum Level : uint8_t
+    {
+        Normal,    //!< 全部功能
+        History,   //!< 指标历史每 10 s 采样一次
+        Refresh,   //!< 另将 `watch` 刷新间隔放宽至 5 s
+        Minimal,   //!< 另暂停指标历史采样并停用 `graph` 渲染
+        LEVELS,
+    };
+
+    static constexpr const char *LEVEL_DESC[LEVELS] = {
+        "all features",
+        "history sampled every 10 s",
+        "history every 10 s, watch refresh 5 s",
+        "history paused, watch refresh 5 s, graph disabled",
+    };
+
+    double budget{}; //!< 预算，单核的比例，为 0 时不限制
+
+    //! 更新占用率估计并调整降级等级
+    void update()
+    {
+        auto now = std::chrono::steady_clock::now();
+        auto classes = ThreadPlacement::global().cpu_time();
+        timespec ts{};
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        uint64_t total = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if (last_wall != std::chrono::steady_clock::time_point{})
+        {
+            double wall = std::chrono::duration<double, std::nano>(now - last_wall).count();
+            if (wall <= 0)
+                return;
+            constexpr double ALPHA = 0.3;
+            double sample = (total - last_total) / wall;
+            smoothed = seen ? smoothed + ALPHA * (sample - smoothed) : sample;
+            for (size_t i = 0; i < classes.size(); i++)
+                per_class[i] = classes[i] > last_class[i] ? (classes[i] - last_class[i]) / wall : 0;
+            seen = true;
+            adjust();
+        }
+        last_wall = now;
+        last_total = total;
+        last_class = classes;
+    }
+
+    //! 当前降级等级
+    Level level() const { return current.load(std::memory_order_relaxed); }
+
+    //! 平滑后的进程 CPU 占用率（单核的比例）
+    double usage() const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return smoothed;
+    }
+
+    //! 最近 1 s 各线程类别的 CPU 占用率（单核的比例）
+    std::array<double, ThreadPlacement::CLASSES> class_usage() const
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return per_class;
+    }
+
+    //! 降级等级变化的累计次数
+    uint64_t transitions() const { return changes.load(std::memory_order_relaxed); }
+
+private:
+    void adjust()
+    {
+        Level lvl = current.load(std::memory_order_relaxed);
+        if (budget <= 0)
+        {
+            set(Normal);
+            return;
+        }
+        over = smoothed > budget ? over + 1 : 0;
+        under = smoothed < 0.6 * budget ? under + 1 : 0;
+        if (over >= 3 && lvl + 1 < LEVELS)
+            set(static_cast<Level>(lvl + 1));
+        else if (under >= 10 && lvl > Normal)
+            set(static_cast<Level>(lvl - 1));
+    }
+
+    void set(Level lvl)
+    {
+        if (current.exchange(lvl, std::memory_order_relaxed) != lvl)
+            changes.fetch_add(1, std::memory_order_relaxed);
+        over = under = 0;
+    }
+
+    mutable std::mutex mtx;
+    std::atomic<Level> current{Normal};
+    std::atomic<uint64_t> changes{};
+    std::chrono::steady_clock::time_point last_wall;
+    uint64_t last_total{};
+    std::array<uint64_t, ThreadPlacement::CLASSES> last_class{};
+    std::array<double, ThreadPlacement::CLASSES> per_class{};
+    double smoothed{};
+    bool seen{};
+    int over{}, under{};
+};
@@ -0,0 +1,293 @@
+/**
+ * @file graph_layout.hpp
+ * @author Nq139 (fnq409997@gmail.com)
+ * @brief 保留历史坐标、增量求解的力导向图布局
+ * @copyright Copyright 2026, Nq139
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "traffic_sketch.hpp"
+
+/**
+ * @brief 增量力导向布局
+ * @details 以 Fruchterman-Reingold 模型求解，斥力只在相邻网格单元内计算，每轮迭代为 O(V + E)。各顶点的坐标与邻接
+ *          签名在多次布局之间保留：
+ * - 坐标已知且邻接未变的顶点固定不动，保证多次渲染之间画面稳定
+ * - 新顶点放置在已放置邻居的重心附近，再与邻接发生变化的顶点一起迭代，迭代只计算这些活动顶点
+ * - 已知坐标不足一半时（首次布局或拓扑大幅变化）对全部顶点冷启动求解
+ */
+class GraphLayout
+{
+public:
+    static constexpr double EDGE_LEN = 72; //!< 理想边长（pt）
+
+    struct Point
+    {
+        double x, y;
+    };
+
+    //! 最近一次布局的统计
+    struct Stats
+    {
+        size_t vertices{};   //!< 顶点数
+        size_t active{};     //!< 参与迭代的顶点数
+        size_t iterations{}; //!< 迭代轮数
+        bool cold{};         //!< 是否冷启动
+        double ms{};         //!< 耗时（毫秒）
+    };
+
+    /**
+     * @brief 计算布局并保存各顶点坐标
+     * @param[in] ids 顶点标识，跨多次布局保持不变
+     * @param[in] edges 边，元素为顶点下标对，方向不影响布局
+     * @return 与 `ids` 一一对应的坐标
+     */
+    std::vector<Point> layout(const std::vector<uint64_t> &ids, const std::vector<std::pair<uint32_t, uint32_t>> &edges)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        size_t n = ids.size();
+        // 邻接表（CSR）
+        std::vector<uint32_t> begin(n + 1), adj(edges.size() * 2);
+        for (auto [a, b] : edges)
+            begin[a + 1]++, begin[b + 1]++;
+        for (size_t i = 0; i < n; i++)
+            begin[i + 1] += begin[i];
+        {
+            std::vector<uint32_t> fill(begin.begin(), begin.end() - 1);
+            for (auto [a, b] : edges)
+                adj[fill[a]++] = b, adj[fill[b]++] = a;
+        }
+
+        std::vector<Point> pos(n);
+        std::vector<uint64_t> sig(n);
+        std::vector<uint8_t> placed(n), active(n);
+        size_t known = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            for (uint32_t j = begin[i]; j < begin[i + 1]; j++)
+                sig[i] += mix64(ids[adj[j]]);
+            auto it = positions.find(ids[i]);
+            if (it == positions.end())
+                continue;
+            pos[i] = it->second.p;
+            placed[i] = 1;
+            // 签名为 0 的坐标来自文件，视为邻接未变
+            active[i] = it->second.sig && it->second.sig != sig[i];
+            known++;
+        }
+        bool cold = known * 2 < n;
+        place_new(ids, begin, adj, pos, placed, active);
+        if (cold)
+            std::fill(active.begin(), active.end(), 1);
+
+        std::vector<uint32_t> moving;
+        Grid fixed;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            if (active[i])
+                moving.push_back(i);
+            else
+                fixed[cell_of(pos[i])].push_back(i);
+        }
+        size_t iterations = moving.empty() ? 0 : cold ? 80 : 40;
+        double side = std::sqrt(static_cast<double>(n)) * EDGE_LEN;
+        double t_start = cold ? side / 10 : EDGE_LEN * 2, t_end = EDGE_LEN / 20;
+        for (size_t iter = 0; iter < iterations; iter++)
+        {
+            double temp = t_start + (t_end - t_start) * iter / iterations;
+            step(begin, adj, moving, fixed, pos, temp);
+        }
+
+        for (size_t i = 0; i < n; i++)
+            positions[ids[i]] = {pos[i], sig[i]};
+        // 已消失的顶点保留坐标以便重新出现时复位，超出当前规模过多时清理
+        if (positions.size() > 2 * n + 1024)
+        {
+            std::unordered_map<uint64_t, Entry> keep;
+            for (size_t i = 0; i < n; i++)
+                keep[ids[i]] = positions[ids[i]];
+            positions.swap(keep);
+        }
+        last = {n, moving.size(), iterations, cold,
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count()};
+        return pos;
+    }
+
+    //! 最近一次布局的统计
+    const Stats &stats() const { return last; }
+
+    //! 已保存坐标的顶点数
+    size_t size() const { return positions.size(); }
+
+    /**
+     * @brief 从文件读取坐标，每行为 `<十六进制标识> <x> <y>`
+     * @return 是否读取成功
+     */
+    bool load(const char *path)
+    {
+        FILE *fp = fopen(path, "r");
+        if (!fp)
+            return false;
+        unsigned long long id;
+        double x, y;
+        while (fscanf(fp, "%llx %lf %lf", &id, &x, &y) == 3)
+            positions[id] = {{x, y}, 0};
+        fclose(fp);
+        return true;
+    }
+
+    //! 将坐标写入文件
+    bool save(const char *path) const
+    {
+        FILE *fp = fopen(path, "w");
+        if (!fp)
+            return false;
+        for (auto &[id, e] : positions)
+            fprintf(fp, "%llx %.1f %.1f\n", static_cast<unsigned long long>(id), e.p.x, e.p.y);
+        return fclose(fp) == 0;
+    }
+
+private:
+    struct Entry
+    {
+        Point p;      //!< 坐标
+        uint64_t sig; //!< 邻接签名，各邻居标识哈希之和
+    };
+
+    /**
+     * @brief 放置没有已知坐标的顶点
+     * @details 反复将已有邻居被放置的顶点放在邻居重心附近，直至不再有进展；其余顶点（孤立的新连通分量）放在已有布局的
+     *          右侧。偏移由顶点标识确定，同一拓扑总是得到相同的布局
+     */
+    static void place_new(const std::vector<uint64_t> &ids, const std::vector<uint32_t> &begin, const std::vector<uint32_t> &adj,
+                          std::vector<Point> &pos, std::vector<uint8_t> &placed, std::vector<uint8_t> &active)
+    {
+        size_t n = ids.size();
+        auto jitter = [&](size_t i, int axis) {
+            return (static_cast<double>(mix64(ids[i] + axis) >> 11) / (1ULL << 53) - 0.5) * EDGE_LEN;
+        };
+        for (bool progress = true; progress;)
+        {
+            progress = false;
+            for (size_t i = 0; i < n; i++)
+            {
+                if (placed[i])
+                    continue;
+                Point c{0, 0};
+                size_t cnt = 0;
+                for (uint32_t j = begin[i]; j < begin[i + 1]; j++)
+                    if (placed[adj[j]] == 1)
+                        c.x += pos[adj[j]].x, c.y += pos[adj[j]].y, cnt++;
+                if (!cnt)
+                    continue;
+                pos[i] = {c.x / cnt + jitter(i, 0), c.y / cnt + jitter(i, 1)};
+                placed[i] = 2; // 本轮放置的顶点下一轮才作为邻居参与计算，结果与遍历顺序无关
+                active[i] = 1;
+                progress = true;
+            }
+            for (auto &p : placed)
+                p = p ? 1 : 0;
+        }
+        double right = 0;
+        bool any = false;
+        for (size_t i = 0; i < n; i++)
+            if (placed[i])
+                right = any ? std::max(right, pos[i].x) : pos[i].x, any = true;
+        size_t rest = 0;
+        for (size_t i = 0; i < n; i++)
+            rest += !placed[i];
+        double side = std::sqrt(static_cast<double>(rest)) * EDGE_LEN;
+        for (size_t i = 0; i < n; i++)
+        {
+            if (placed[i])
+                continue;
+            pos[i] = {right + EDGE_LEN + (jitter(i, 0) / EDGE_LEN + 0.5) * side, (jitter(i, 1) / EDGE_LEN + 0.5) * side};
+            placed[i] = 1;
+            active[i] = 1;
+        }
+    }
+
+    using Grid = std::unordered_map<uint64_t, std::vector<uint32_t>>;
+
+    static constexpr double CELL = 2 * EDGE_LEN; //!< 网格单元边长，亦为斥力的作用范围
+
+    static uint64_t cell_key(int32_t cx, int32_t cy)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+    }
+
+    static uint64_t cell_of(const Point &p)
+    {
+        return cell_key(static_cast<int32_t>(std::floor(p.x / CELL)), static_cast<int32_t>(std::floor(p.y / CELL)));
+    }
+
+    /**
+     * @brief 对活动顶点迭代一轮，位移不超过 `temp`
+     * @param fixed 固定顶点的网格，跨迭代复用，每轮只需重建活动顶点的网格
+     */
+    static void step(const std::vector<uint32_t> &begin, const std::vector<uint32_t> &adj, const std::vector<uint32_t> &moving,
+                     const Grid &fixed, std::vector<Point> &pos, double temp)
+    {
+        constexpr double K = EDGE_LEN;
+        Grid grid;
+        grid.reserve(moving.size());
+        for (uint32_t i : moving)
+            grid[cell_of(pos[i])].push_back(i);
+
+        std::vector<Point> disp(moving.size(), Point{0, 0});
+        for (size_t m = 0; m < moving.size(); m++)
+        {
+            uint32_t i = moving[m];
+            Point &d = disp[m];
+            uint64_t c = cell_of(pos[i]);
+            auto cx = static_cast<int32_t>(c >> 32), cy = static_cast<int32_t>(c);
+            for (int dx = -1; dx <= 1; dx++)
+                for (int dy = -1; dy <= 1; dy++)
+                    for (const Grid *g : {&std::as_const(grid), &fixed})
+                    {
+                        auto it = g->find(cell_key(cx + dx, cy + dy));
+                        if (it == g->end())
+                            continue;
+                        for (uint32_t j : it->second)
+                        {
+                            if (j == i)
+                                continue;
+                            double vx = pos[i].x - pos[j].x, vy = pos[i].y - pos[j].y, d2 = vx * vx + vy * vy;
+                            if (d2 < 1e-4) // 重合时按下标错开
+                                vx = i < j ? 0.01 : -0.01, vy = 0, d2 = 1e-4;
+                            if (d2 > CELL * CELL)
+                                continue;
+                            double f = K * K / d2;
+                            d.x += vx * f, d.y += vy * f;
+                        }
+                    }
+            for (uint32_t e = begin[i]; e < begin[i + 1]; e++)
+            {
+                uint32_t j = adj[e];
+                double vx = pos[i].x - pos[j].x, vy = pos[i].y - pos[j].y;
+                double f = std::sqrt(vx * vx + vy * vy) / K;
+                d.x -= vx * f, d.y -= vy * f;
+            }
+        }
+        for (size_t m = 0; m < moving.size(); m++)
+        {
+            auto &d = disp[m];
+            double len = std::sqrt(d.x * d.x + d.y * d.y);
+            if (len > temp)
+                d.x *= temp / len, d.y *= temp / len;
+            pos[moving[m]].x += d.x, pos[moving[m]].y += d.y;
+        }
+    }
+
+    std::unordered_map<uint64_t, Entry> positions;
+    Stats last;
+};
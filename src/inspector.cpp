@@ -0,0 +1,964 @@
+/**
+ * @file inspector.cpp
+ * @author Nq139 (fnq409997@gmail.com)
+ * @brief LPSS 拓扑发现引擎的实现
+ * @copyright Copyright 2026, Nq139
+ */
+
+#include <cstdio>
+#include <ifaddrs.h>
+#include <netinet/in.h>
+#include <thread>
+
+#include <rmvl/io/socket.hpp>
+
+#include "inspector.hpp"
+#include "metrics.hpp"
+#include "packet_capture.hpp"
+#include "thread_placement.hpp"
+#include "udp_receiver.hpp"
+
+using namespace rm;
+using namespace rm::lpss;
+using namespace std::chrono_literals;
+
+//! RNDP 组播端口
+constexpr uint16_t RNDP_PORT = 7500;
+
+NodeColumns copy_columns(const MonitorState &state, Clock::time_point now, bool with_topics)
+{
+    NodeColumns cols = state.columns;
+    size_t n = cols.size();
+    auto &age = cols.num[NodeColumns::AGE];
+    for (size_t i = 0; i < n; i++)
+        age[i] = std::chrono::duration<double>(now - cols.last_seen[i]).count();
+    if (!with_topics)
+        return cols;
+    cols.topic_begin.reserve(n + 1);
+    for (size_t i = 0; i < n; i++)
+    {
+        cols.topic_begin.push_back(static_cast<uint32_t>(cols.topics.size()));
+        auto eps = state.topics.find(cols.prefix[i]);
+        if (eps != state.topics.end())
+            for (auto &[guid, ep] : eps->second)
+                cols.topics.push_back(ep.topic_id);
+    }
+    cols.topic_begin.push_back(static_cast<uint32_t>(cols.topics.size()));
+    return cols;
+}
+
+Snapshot take_snapshot(MonitorState &state)
+{
+    Snapshot snap;
+    snap.nodes.reserve(state.nodes.size());
+    for (auto &[prefix, node] : state.nodes)
+        snap.nodes.push_back({prefix, node.name_id});
+    for (auto &[prefix, endpoints] : state.topics)
+        for (auto &[guid, ep] : endpoints)
+            snap.endpoints.push_back({guid, ep.topic_id, ep.is_pub});
+    std::sort(snap.nodes.begin(), snap.nodes.end(), [](auto &a, auto &b) { return a.prefix < b.prefix; });
+    std::sort(snap.endpoints.begin(), snap.endpoints.end(), [](auto &a, auto &b) { return a.guid < b.guid; });
+    return snap;
+}
+
+/**
+ * @brief 向全部订阅者发布拓扑增量事件
+ * @param state 全局状态对象，调用方需持有 `state->mtx`
+ * @param e 事件
+ */
+void emit(MonitorState *state, const TopologyEvent &e)
+{
+    for (auto &[id, observer] : state->observers)
+        observer(e);
+}
+
+/**
+ * @brief 把节点的名字、心跳统计与保留状态写入其在列式视图中的行
+ * @param state 全局状态对象，调用方需持有 `state->mtx`
+ * @param node 节点
+ */
+void sync_row(MonitorState *state, const NodeInfo &node)
+{
+    auto &cols = state->columns;
+    cols.name[node.row] = node.name_id;
+    cols.num[NodeColumns::PERIOD][node.row] = node.hb.period;
+    cols.num[NodeColumns::JITTER][node.row] = node.hb.jitter;
+    cols.num[NodeColumns::LOSS][node.row] = node.hb.loss;
+    cols.num[NodeColumns::HELD][node.row] = node.held;
+    cols.last_seen[node.row] = node.hb.last_seen;
+}
+
+/**
+ * @brief 为新节点在列式视图中追加一行，计入节点出现之前已收到的端点
+ * @param state 全局状态对象，调用方需持有 `state->mtx`
+ * @param prefix 节点 GUID 前缀
+ * @param node 节点
+ */
+void add_row(MonitorState *state, uint64_t prefix, NodeInfo &node)
+{
+    auto &cols = state->columns;
+    node.row = cols.add(prefix);
+    auto eps = state->topics.find(prefix);
+    if (eps == state->topics.end())
+        return;
+    for (auto &[guid, ep] : eps->second)
+        cols.num[ep.is_pub ? NodeColumns::PUBS : NodeColumns::SUBS][node.row]++;
+    cols.num[NodeColumns::EPS][node.row] = static_cast<double>(eps->second.size());
+}
+
+/**
+ * @brief 从列式视图中删除节点的行
+ * @param state 全局状态对象，调用方需持有 `state->mtx`
+ * @param node 节点
+ */
+void drop_row(MonitorState *state, const NodeInfo &node)
+{
+    auto &cols = state->columns;
+    cols.remove(node.row);
+    if (node.row < cols.size())
+        state->nodes.at(cols.prefix[node.row]).row = node.row;
+}
+
+/**
+ * @brief 端点增减时更新其所属节点在列式视图中的端点计数
+ * @param state 全局状态对象，调用方需持有 `state->mtx`
+ * @param prefix 节点 GUID 前缀，节点不存在时忽略
+ * @param is_pub 端点类型
+ * @param delta 增加为 1，减少为 -1
+ */
+void count_endpoint(MonitorState *state, uint64_t prefix, bool is_pub, int delta)
+{
+    auto node = state->nodes.find(prefix);
+    if (node == state->nodes.end())
+        return;
+    auto &num = state->columns.num;
+    num[is_pub ? NodeColumns::PUBS : NodeColumns::SUBS][node->second.row] += delta;
+    num[NodeColumns::EPS][node->second.row] += delta;
+}
+
+/**
+ * @brief 解除节点对其身份键的持有
+ * @param state 全局状态对象，调用方需持有 `state->mtx`
+ * @param prefix 节点 GUID 前缀
+ * @param identity 节点当前的身份键
+ */
+void forget_identity(MonitorState *state, uint64_t prefix, uint64_t identity)
+{
+    auto it = state->identities.find(identity);
+    if (it != state->identities.end() && it->second == prefix)
+        state->identities.erase(it);
+}
+
+/**
+ * @brief 解除节点对其 REDP 定位器的引用
+ * @param state 全局状态对象，调用方需持有 `state->mtx`
+ * @param locator 定位器的键，为 0 时忽略
+ */
+void forget_locator(MonitorState *state, uint64_t locator)
+{
+    auto it = state->locators.find(locator);
+    if (it != state->locators.end() && --it->second == 0)
+        state->locators.erase(it);
+}
+
+/**
+ * @brief 移除节点及其全部端点
+ * @param state 全局状态对象，调用方需持有 `state->mtx`
+ * @param prefix 节点 GUID 前缀
+ * @return 随节点一并移除的端点数
+ */
+size_t remove_node(MonitorState *state, uint64_t prefix)
+{
+    size_t removed = 0;
+    state->reach.remove_node(prefix);
+    auto eps = state->topics.find(prefix);
+    if (eps != state->topics.end())
+    {
+        for (auto &[guid, ep] : eps->second)
+            emit(state, {TopologyEvent::Kind::EndpointRemoved, prefix, {}, state->names.str(ep.topic_id), ep.is_pub});
+        removed = eps->second.size();
+        state->topics.erase(eps);
+    }
+    auto node = state->nodes.find(prefix);
+    if (node != state->nodes.end())
+    {
+        // 被保留的节点在超时时已发布过下线事件
+        if (!node->second.held)
+            emit(state, {TopologyEvent::Kind::NodeDown, prefix, state->names.str(node->second.name_id)});
+        forget_identity(state, prefix, node->second.identity);
+        forget_locator(state, node->second.locator);
+        state->superseded.erase(prefix);
+        drop_row(state, node->second);
+        state->nodes.erase(node);
+    }
+    return removed;
+}
+
+/**
+ * @brief 移除端点，节点不再有端点时一并回收其端点表
+ * @param state 全局状态对象，调用方需持有 `state->mtx`
+ * @param guid 完整的端点 GUID
+ */
+void remove_endpoint(MonitorState *state, uint64_t guid)
+{
+    uint64_t prefix = guid & 0xFFFFFFFFFFFFULL;
+    auto it = state->topics.find(prefix);
+    if (it == state->topics.end())
+        return;
+    auto ep = it->second.find(guid);
+    if (ep == it->second.end())
+        return;
+    state->reach.remove_endpoint(prefix, ep->second.topic_id, ep->second.is_pub);
+    count_endpoint(state, prefix, ep->second.is_pub, -1);
+    emit(state, {TopologyEvent::Kind::EndpointRemoved, prefix, {}, state->names.str(ep->second.topic_id), ep->second.is_pub});
+    it->second.erase(ep);
+    if (it->second.empty())
+        state->topics.erase(it);
+}
+
+/**
+ * @brief 超出内存预算时按最近出现时间由旧到新淘汰节点与端点
+ * @note 端点的 REDP 通告远少于节点心跳，若其所属节点在端点入链后仍有心跳，则以节点的出现时间重新入链一次，
+ *       而不在每次心跳时逐个刷新端点。可达性索引随端点增减，一并计入预算。淘汰节点时其端点随之释放并计入淘汰的端点数，它们的字节数在析构时即从
+ *       链表总量中扣除，因此每淘汰一个条目后都以实际剩余的字节数判断是否继续
+ * @param state 全局状态对象，调用方需持有 `state->mtx`
+ */
+void enforce_budget(MonitorState *state)
+{
+    if (!state->mem_cap)
+        return;
+    size_t before = state->budget_bytes();
+    while (state->budget_bytes() > state->mem_cap)
+    {
+        auto *h = state->lru.oldest();
+        if (!h)
+            break;
+        uint64_t key = h->key;
+        if (!h->is_endpoint)
+        {
+            state->evicted_endpoints += remove_node(state, key);
+            state->evicted_nodes++;
+            continue;
+        }
+        uint64_t prefix = key & 0xFFFFFFFFFFFFULL;
+        auto node = state->nodes.find(prefix);
+        if (node != state->nodes.end() && node->second.hb.last_seen > h->stamp)
+        {
+            state->lru.touch(*h, key, true, node->second.hb.last_seen, h->bytes);
+            continue;
+        }
+        remove_endpoint(state, key);
+        state->evicted_endpoints++;
+    }
+    state->evicted_bytes += before - std::min(before, state->budget_bytes());
+}
+
+/**
+ * @brief Get the local ip object
+ * @return std::array<uint8_t, 4>
+ */
+std::array<uint8_t, 4> get_local_ip()
+{
+    std::array<uint8_t, 4> res = {0};
+    struct ifaddrs *ifa;
+    getifaddrs(&ifa);
+    for (auto *p = ifa; p; p = p->ifa_next)
+    {
+        if (p->ifa_addr && p->ifa_addr->sa_family == AF_INET && strcmp(p->ifa_name, "lo") != 0)
+        {
+            memcpy(res.data(), &((struct sockaddr_in *)p->ifa_addr)->sin_addr.s_addr, 4);
+            break;
+        }
+    }
+    if (ifa)
+        freeifaddrs(ifa);
+    return res;
+}
+
+
+/**
+ * @brief 记录数据报自内核收包至用户态处理的调度延迟
+ * @param dgram 已接收的数据报
+ */
+void record_arrival(const Datagram &dgram)
+{
+    static const auto sched_delay = metrics().histogram("ingest.sched_delay_ns");
+    static const auto untimed = metrics().counter("ingest.no_kernel_ts");
+    if (dgram.kernel_ts)
+        sched_delay.record(dgram.sched_delay.count());
+    else
+        untimed.add();
+}
+
+/**
+ * @brief 将数据报计入本线程的流量摘要
+ * @param shard 本线程的摘要分片
+ * @param dgram 已接收的数据报
+ * @param topic 报文所属话题，无话题时为空
+ */
+void record_traffic(TrafficStats::Shard &shard, const Datagram &dgram, std::string_view topic)
+{
+    auto ip = reinterpret_cast<const uint8_t *>(&dgram.addr);
+    char label[24];
+    int len = snprintf(label, sizeof(label), "%u.%u.%u.%u:%u", ip[0], ip[1], ip[2], ip[3], dgram.port);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    shard.sketch.add(TrafficSketch::source_key(dgram.addr, dgram.port), {label, static_cast<size_t>(len)}, topic,
+                     dgram.data.size());
+}
+
+/**
+ * @brief 数据报的到达时刻
+ * @note 虚拟时间模式下内核时间戳没有意义，以当前虚拟时间为准
+ */
+Clock::time_point arrival_of(const Datagram &dgram) { return Clock::is_virtual() ? Clock::now() : dgram.arrival; }
+
+/**
+ * @brief 识别重启的节点
+ * @details 新出现的 GUID 与某个已知节点的身份键（节点名与定位器地址）相同时，视为该节点以新 GUID 重启：心跳统计与指标
+ *          历史迁移到新条目，旧条目暂不回收，待其错过预期的下一次通告后由 `retire_superseded()` 连同端点一并回收，
+ *          不必等到超时。新节点的上线事件因此先于旧节点的下线事件发布，重启不会表现为一次中断。旧 GUID 在此之前或回收后
+ *          `NODE_TTL` 内再次出现，说明二者实为同名同址的两个存活节点，此后不再按该身份合并
+ * @param state 全局状态对象，调用方需持有 `state->mtx`
+ * @param prefix 新节点的 GUID 前缀，其条目已创建
+ * @param name 新节点的节点名
+ * @param identity 新节点的身份键
+ */
+void reconcile_restart(MonitorState *state, uint64_t prefix, const std::string &name, uint64_t identity)
+{
+    if (state->retired.erase(prefix))
+    {
+        state->ambiguous.insert(identity);
+        return;
+    }
+    if (state->ambiguous.count(identity))
+        return;
+    auto id = state->identities.find(identity);
+    if (id == state->identities.end())
+        return;
+    auto old = state->nodes.find(id->second);
+    if (old == state->nodes.end() || state->names.str(old->second.name_id) != name)
+        return;
+    auto &node = state->nodes.at(prefix);
+    node.hb = old->second.hb;
+    node.history = std::move(old->second.history);
+    node.cost = old->second.cost;
+    state->superseded.insert(old->first);
+}
+
+/**
+ * @brief 回收已错过预期通告的重启前旧节点，参见 `reconcile_restart()`
+ * @param state 全局状态对象，调用方需持有 `state->mtx`
+ * @param now 当前时间
+ */
+void retire_superseded(MonitorState *state, Clock::time_point now)
+{
+    static const auto restarts = metrics().counter("ingest.node_restarts");
+    std::vector<uint64_t> overdue;
+    for (uint64_t prefix : state->superseded)
+        if (state->nodes.at(prefix).hb.overdue(now))
+            overdue.push_back(prefix);
+    for (uint64_t prefix : overdue)
+    {
+        remove_node(state, prefix);
+        state->retired[prefix] = now;
+        state->restart_total++;
+        restarts.add();
+    }
+}
+
+/**
+ * @brief 把一个发现报文的开销计入全网统计及其所属节点
+ * @note 调用方需持有 `state->mtx`
+ * @param state 全局状态对象
+ * @param prefix 报文所属节点的 GUID 前缀，节点不存在（如尚未收到其 RNDP）时只计入全网统计
+ * @param dgram 数据报
+ * @param now 当前时间
+ * @param begin 开始处理该报文的真实时刻
+ * @param waited 等待状态锁的真实耗时，不计入处理耗时
+ */
+void charge_discovery(MonitorState *state, uint64_t prefix, const Datagram &dgram, Clock::time_point now,
+                      std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::duration waited)
+{
+    auto spent = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin - waited).count();
+    auto ns = static_cast<uint64_t>(std::max<int64_t>(spent, 0));
+    state->discovery.add(now, dgram.data.size(), ns);
+    if (auto it = state->nodes.find(prefix); it != state->nodes.end())
+        it->second.cost.add(now, dgram.data.size(), ns);
+}
+
+/**
+ * @brief 处理一个 RNDP 端口上收到的数据报
+ * @note 节点的最近出现时刻与心跳统计均以内核接收时间戳为准
+ * @param state 全局状态对象
+ * @param traffic 调用线程的流量摘要分片
+ * @param dgram 数据报
+ */
+void ingest_rndp(MonitorState *state, TrafficStats::Shard &traffic, const Datagram &dgram)
+{
+    static const auto packets = metrics().counter("ingest.rndp_packets");
+    static const auto bytes = metrics().counter("ingest.bytes");
+    static const auto malformed = metrics().counter("ingest.malformed");
+    static const auto lock_wait = metrics().histogram("ingest.lock_wait_ns");
+    auto begin = std::chrono::steady_clock::now();
+    auto data = dgram.data;
+    bytes.add(data.size());
+    record_arrival(dgram);
+    record_traffic(traffic, dgram, {});
+    if (data.size() < 14 || data[0] != 'N')
+    {
+        malformed.add();
+        return;
+    }
+    packets.add();
+    auto msg = RNDPMessage::deserialize(data.data());
+    auto now = arrival_of(dgram);
+    auto t0 = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(state->mtx);
+    auto waited = std::chrono::steady_clock::now() - t0;
+    lock_wait.record(std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count());
+    // 定位器地址取自通告，无定位器时取发送方地址
+    uint32_t addr = dgram.addr;
+    uint64_t locator = 0;
+    if (!msg.locators.empty())
+    {
+        memcpy(&addr, msg.locators.front().ip.data(), sizeof(addr));
+        locator = locator_key(addr, msg.locators.front().port);
+    }
+    uint64_t identity = identity_key(msg.name, addr);
+    uint64_t prefix = get_prefix(msg.guid);
+    auto [it, inserted] = state->nodes.try_emplace(prefix);
+    auto &node = it->second;
+    if (inserted)
+    {
+        reconcile_restart(state, it->first, msg.name, identity);
+        add_row(state, it->first, node);
+    }
+    else if (state->superseded.erase(prefix))
+    {
+        // 被判定为重启前旧进程的节点仍在通告，二者实为同名同址的两个存活节点
+        state->ambiguous.insert(identity);
+    }
+    if (node.identity != identity)
+    {
+        forget_identity(state, it->first, node.identity);
+        node.identity = identity;
+        if (!state->ambiguous.count(identity))
+            state->identities[identity] = it->first;
+    }
+    if (node.locator != locator)
+    {
+        forget_locator(state, node.locator);
+        node.locator = locator;
+        if (locator)
+            state->locators[locator]++;
+    }
+    if (inserted || node.held)
+    {
+        state->appear_rate.add(now);
+        state->appear_total++;
+        node.held = false;
+        node.name_id = state->names.intern(msg.name);
+        emit(state, {TopologyEvent::Kind::NodeUp, it->first, msg.name});
+    }
+    else if (state->names.str(node.name_id) != msg.name)
+    {
+        emit(state, {TopologyEvent::Kind::NodeDown, it->first, state->names.str(node.name_id)});
+        node.name_id = state->names.intern(msg.name);
+        emit(state, {TopologyEvent::Kind::NodeUp, it->first, msg.name});
+    }
+    node.hb.update(now);
+    sync_row(state, node);
+    state->lru.touch(node.lru, it->first, false, now, node.footprint(state->names));
+    // 预算极小时本节点可能被立即淘汰，此后不能再访问 it
+    enforce_budget(state);
+    charge_discovery(state, prefix, dgram, now, begin, waited);
+}
+
+/**
+ * @brief 处理一个 REDP 端口上收到的数据报
+ * @param state 全局状态对象
+ * @param traffic 调用线程的流量摘要分片
+ * @param dgram 数据报
+ */
+void ingest_redp(MonitorState *state, TrafficStats::Shard &traffic, const Datagram &dgram)
+{
+    static const auto packets = metrics().counter("ingest.redp_packets");
+    static const auto bytes = metrics().counter("ingest.bytes");
+    static const auto malformed = metrics().counter("ingest.malformed");
+    static const auto lock_wait = metrics().histogram("ingest.lock_wait_ns");
+    auto begin = std::chrono::steady_clock::now();
+    auto data = dgram.data;
+    bytes.add(data.size());
+    record_arrival(dgram);
+    if (data.size() < 14 || data[0] != 'E')
+    {
+        record_traffic(traffic, dgram, {});
+        malformed.add();
+        return;
+    }
+    packets.add();
+    auto msg = REDPMessage::deserialize(data.data());
+    record_traffic(traffic, dgram, msg.topic);
+    auto now = arrival_of(dgram);
+    auto t0 = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(state->mtx);
+    auto waited = std::chrono::steady_clock::now() - t0;
+    lock_wait.record(std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count());
+    uint64_t prefix = get_prefix(msg.endpoint_guid);
+    if (msg.action == REDPMessage::Action::Delete)
+    {
+        // 显式撤销：立即移除端点，节点不再有端点时一并回收
+        remove_endpoint(state, msg.endpoint_guid.full);
+        charge_discovery(state, prefix, dgram, now, begin, waited);
+        return;
+    }
+    auto [it, inserted] = state->topics[prefix].try_emplace(msg.endpoint_guid.full);
+    auto &ep = it->second;
+    bool is_pub = (msg.type == REDPMessage::Type::Writer);
+    uint32_t topic_id = state->names.intern(msg.topic);
+    if (inserted || ep.topic_id != topic_id || ep.is_pub != is_pub)
+    {
+        if (!inserted)
+        {
+            state->reach.remove_endpoint(prefix, ep.topic_id, ep.is_pub);
+            count_endpoint(state, prefix, ep.is_pub, -1);
+            emit(state, {TopologyEvent::Kind::EndpointRemoved, prefix, {}, state->names.str(ep.topic_id), ep.is_pub});
+        }
+        ep.topic_id = topic_id;
+        state->reach.add_endpoint(prefix, ep.topic_id, is_pub);
+        count_endpoint(state, prefix, is_pub, 1);
+        emit(state, {TopologyEvent::Kind::EndpointAdded, prefix, {}, msg.topic, is_pub});
+    }
+    ep.is_pub = is_pub;
+    ep.last_seen = now;
+    ep.held = false;
+    state->lru.touch(ep.lru, msg.endpoint_guid.full, true, now, ep.footprint(state->names));
+    enforce_budget(state);
+    charge_discovery(state, prefix, dgram, now, begin, waited);
+}
+
+//! 按报文类型分派数据报
+void ingest(MonitorState *state, TrafficStats::Shard &traffic, const Datagram &dgram)
+{
+    if (!dgram.data.empty() && dgram.data[0] == 'N')
+        ingest_rndp(state, traffic, dgram);
+    else
+        ingest_redp(state, traffic, dgram);
+}
+
+/**
+ * @brief 数据报是否发往某个存活节点通告的 REDP 定位器
+ * @param state 全局状态对象
+ * @param dgram 抓包得到的数据报
+ */
+bool to_known_locator(MonitorState *state, const Datagram &dgram)
+{
+    std::lock_guard<std::mutex> lock(state->mtx);
+    return state->locators.count(locator_key(dgram.dst_addr, dgram.dst_port));
+}
+
+/**
+ * @brief 被动模式下持续抓包，从其他节点之间交换的 RNDP 与 REDP 报文中收集节点与话题信息
+ * @note 抓到的是本机全部 UDP 流量，只处理发往 RNDP 组播端口或组播组的 RNDP 报文，以及发往已知节点 REDP 定位器的
+ *       REDP 报文，其余不计入畸形报文。抓包环中的报文之后没有结尾的 `'\0'`，先复制到缓冲区再交给依赖它的反序列化
+ */
+void task_capture(MonitorState *state, PacketCapture &&cap)
+{
+    auto placed = ThreadPlacement::global().enter(ThreadPlacement::Receive, "lpss-capture");
+    auto &traffic = state->traffic.attach();
+    auto packets = metrics().counter("capture.packets");
+    auto drops = metrics().counter("capture.kernel_drops");
+    uint32_t group{};
+    inet_pton(AF_INET, BROADCAST_IP, &group);
+    std::string payload;
+    while (state->running)
+    {
+        packets.add(cap.poll_block(
+            [&](const Datagram &dgram) {
+                auto data = dgram.data;
+                if (data.size() < 14)
+                    return;
+                bool rndp = data[0] == 'N' && (dgram.dst_port == RNDP_PORT || dgram.dst_addr == group);
+                if (!rndp && (data[0] != 'E' || !to_known_locator(state, dgram)))
+                    return;
+                payload.assign(data.data(), data.size());
+                Datagram copy = dgram;
+                copy.data = payload;
+                rndp ? ingest_rndp(state, traffic, copy) : ingest_redp(state, traffic, copy);
+            },
+            500ms));
+        drops.add(cap.drops());
+    }
+}
+
+/**
+ * @brief 持续监听 RNDP 报文，收集网络中节点的信息
+ */
+void task_nodes(MonitorState *state, UdpReceiver &&sock)
+{
+    auto placed = ThreadPlacement::global().enter(ThreadPlacement::Receive, "lpss-rndp");
+    auto &traffic = state->traffic.attach();
+    Datagram dgram;
+    while (state->running)
+        if (sock.recv(dgram)) // 持续监听，超时后重新检查退出标志
+            ingest_rndp(state, traffic, dgram);
+}
+
+/**
+ * @brief 持续监听 REDP 报文，收集网络中节点的发布/订阅话题信息
+ */
+void task_topics(MonitorState *state, UdpReceiver &&sock)
+{
+    auto placed = ThreadPlacement::global().enter(ThreadPlacement::Receive, "lpss-redp");
+    auto &traffic = state->traffic.attach();
+    Datagram dgram;
+    while (state->running)
+        if (sock.recv(dgram))
+            ingest_redp(state, traffic, dgram);
+}
+
+/**
+ * @brief 驻留表中失效的字符串超过半数时紧凑驻留表，并重映射各处保存的 ID
+ * @param state 全局状态对象，调用方需持有 `state->mtx`
+ */
+void compact_names(MonitorState *state)
+{
+    auto &pool = state->names;
+    if (pool.size() < 4096)
+        return;
+    std::vector<bool> live(pool.size());
+    size_t count = 0;
+    auto keep = [&](uint32_t id) { count += !live[id], live[id] = true; };
+    for (auto &[prefix, node] : state->nodes)
+        keep(node.name_id);
+    for (auto &[prefix, endpoints] : state->topics)
+        for (auto &[guid, ep] : endpoints)
+            keep(ep.topic_id);
+    for (auto &[name, snap] : state->marks)
+    {
+        for (auto &n : snap.nodes)
+            keep(n.name);
+        for (auto &e : snap.endpoints)
+            keep(e.topic);
+    }
+    for (auto &[topic, history] : state->topic_history)
+        keep(topic);
+    if (count * 2 > pool.size())
+        return;
+
+    auto remap = pool.compact(live);
+    state->reach.remap_names(remap);
+    for (auto &[prefix, node] : state->nodes)
+        node.name_id = remap[node.name_id];
+    for (auto &id : state->columns.name)
+        id = remap[id];
+    for (auto &[prefix, endpoints] : state->topics)
+        for (auto &[guid, ep] : endpoints)
+            ep.topic_id = remap[ep.topic_id];
+    for (auto &[name, snap] : state->marks)
+    {
+        for (auto &n : snap.nodes)
+            n.name = remap[n.name];
+        for (auto &e : snap.endpoints)
+            e.topic = remap[e.topic];
+    }
+    decltype(state->topic_history) history;
+    history.reserve(state->topic_history.size());
+    for (auto &[topic, h] : state->topic_history)
+        history.emplace(remap[topic], std::move(h));
+    state->topic_history = std::move(history);
+}
+
+/**
+ * @brief 移除超过 `NODE_TTL` 未收到通告的节点及其端点
+ * @note 处于抖动抑制状态的节点被保留，直至惩罚值衰减至解除抑制
+ * @param state 全局状态对象
+ */
+void expire_nodes(MonitorState *state)
+{
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(state->mtx);
+    retire_superseded(state, now);
+    for (auto it = state->nodes.begin(); it != state->nodes.end();)
+    {
+        auto &[prefix, node] = *it;
+        if (now - node.hb.last_seen <= NODE_TTL)
+        {
+            ++it;
+            continue;
+        }
+        bool hold;
+        if (node.held)
+            hold = state->node_flaps.suppressed(prefix, now);
+        else
+        {
+            state->expire_rate.add(now);
+            state->expire_total++;
+            hold = state->node_flaps.flap(prefix, now);
+        }
+        if (hold)
+        {
+            if (!node.held)
+                emit(state, {TopologyEvent::Kind::NodeDown, prefix, state->names.str(node.name_id)});
+            node.held = true;
+            state->columns.num[NodeColumns::HELD][node.row] = 1;
+            ++it;
+        }
+        else
+            remove_node(state, (it++)->first);
+    }
+    state->node_flaps.prune(now);
+    for (auto it = state->retired.begin(); it != state->retired.end();)
+        it = now - it->second > NODE_TTL ? state->retired.erase(it) : std::next(it);
+    // 共用身份的节点全部消失后，该身份重新用于识别重启
+    if (!state->ambiguous.empty())
+    {
+        std::unordered_set<uint64_t> live;
+        for (auto &[prefix, node] : state->nodes)
+            if (state->ambiguous.count(node.identity))
+                live.insert(node.identity);
+        for (auto it = state->ambiguous.begin(); it != state->ambiguous.end();)
+            it = live.count(*it) ? std::next(it) : state->ambiguous.erase(it);
+    }
+
+    if (state->endpoint_ttl > Clock::duration::zero())
+    {
+        std::vector<uint64_t> expired;
+        for (auto &[prefix, endpoints] : state->topics)
+        {
+            for (auto &[guid, info] : endpoints)
+            {
+                if (now - info.last_seen <= state->endpoint_ttl)
+                    continue;
+                bool hold = info.held ? state->endpoint_flaps.suppressed(guid, now)
+                                      : state->endpoint_flaps.flap(guid, now);
+                if (hold)
+                    info.held = true;
+                else
+                    expired.push_back(guid);
+            }
+        }
+        for (uint64_t guid : expired)
+            remove_endpoint(state, guid);
+        state->endpoint_flaps.prune(now);
+    }
+
+    // 条目大量减少后收缩哈希表，归还桶数组占用的内存
+    if (state->nodes.size() < state->nodes.bucket_count() / 4)
+        state->nodes.rehash(0);
+    if (state->topics.size() < state->topics.bucket_count() / 4)
+        state->topics.rehash(0);
+    compact_names(state);
+}
+
+/**
+ * @brief 对各节点与话题的指标进行一次 1 s 采样
+ * @param state 全局状态对象
+ */
+void sample_history(MonitorState *state)
+{
+    struct TopicSample
+    {
+        size_t pubs{}, subs{};
+        Clock::time_point seen{}; //!< 该话题最近一次 REDP 通告的时间
+        bool keep{true};          //!< 是否保留指标历史
+    };
+    std::lock_guard<std::mutex> lock(state->mtx);
+    std::unordered_map<uint32_t, TopicSample> counts;
+    for (auto &[prefix, endpoints] : state->topics)
+        for (auto &[guid, ep] : endpoints)
+        {
+            auto &c = counts[ep.topic_id];
+            (ep.is_pub ? c.pubs : c.subs)++;
+            c.seen = std::max(c.seen, ep.last_seen);
+        }
+    // 话题数超过上限时只为最近有通告的话题保留历史，其余话题的历史被淘汰，直至重新排进上限内
+    size_t limit = state->max_topic_history;
+    if (limit && counts.size() > limit)
+    {
+        std::vector<TopicSample *> ranked;
+        ranked.reserve(counts.size());
+        for (auto &[topic, c] : counts)
+            ranked.push_back(&c);
+        std::nth_element(ranked.begin(), ranked.begin() + limit, ranked.end(),
+                         [](auto *a, auto *b) { return a->seen > b->seen; });
+        for (size_t i = limit; i < ranked.size(); i++)
+            ranked[i]->keep = false;
+    }
+
+    for (auto &[prefix, node] : state->nodes)
+    {
+        if (!node.history)
+            node.history = std::make_unique<NodeHistory>();
+        auto eps = state->topics.find(prefix);
+        auto &hb = node.hb;
+        node.history->endpoints.push(eps != state->topics.end() ? eps->second.size() : 0);
+        node.history->rate.push(hb.period > 0 ? 1 / hb.period : 0);
+        node.history->jitter.push(hb.jitter * 1e3);
+        node.history->loss.push(hb.loss * 100);
+    }
+
+    for (auto it = state->topic_history.begin(); it != state->topic_history.end();)
+    {
+        auto c = counts.find(it->first);
+        it = c != counts.end() && c->second.keep ? std::next(it) : state->topic_history.erase(it);
+    }
+    for (auto &[topic, c] : counts)
+    {
+        if (!c.keep)
+            continue;
+        auto &h = state->topic_history[topic];
+        h.pubs.push(c.pubs);
+        h.subs.push(c.subs);
+    }
+}
+
+/**
+ * @brief 定期广播 RNDP 心跳，诱导网络中的 LPSS 节点回应其存在，并清理超时节点
+ * @note 被动模式下 `announce` 为 `false`，只执行超时清理与历史采样
+ */
+void task_heartbeat(MonitorState *state, Guid my_guid, std::string name, uint16_t port, std::array<uint8_t, 4> ip, bool announce)
+{
+    auto placed = ThreadPlacement::global().enter(ThreadPlacement::Heartbeat, "lpss-heartbeat");
+    Clock::enter();
+    auto sender = rm::Sender(rm::ip::udp::v4()).create();
+    auto sent = metrics().counter("heartbeat.sent");
+    auto sweep = metrics().histogram("heartbeat.sweep_ns");
+    uint64_t ticks = 0;
+    auto next = Clock::now();
+    while (state->running)
+    {
+        if (announce)
+        {
+            RNDPMessage msg;
+            msg.guid = my_guid;
+            msg.name = name;
+            msg.locators.push_back({port, ip});
+            sender.write(BROADCAST_IP, rm::Endpoint(rm::ip::udp::v4(), RNDP_PORT), msg.serialize());
+            sent.add();
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        expire_nodes(state);
+        // 降级时减少或暂停历史采样，发现与超时清理不受影响
+        auto level = state->governor.level();
+        if (level < CpuGovernor::Minimal && (level < CpuGovernor::History || ++ticks % 10 == 0))
+            sample_history(state);
+        state->governor.update();
+        sweep.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());
+        // 按固定节拍而非固定间隔等待，虚拟时间下每个节拍恰好对应 1 s；真实时间下落后过多（如系统挂起）时不补发
+        next = std::max(next + 1s, Clock::now());
+        Clock::sleep_until(next, state->running);
+    }
+    Clock::idle();
+}
+
+Inspector::Inspector(const InspectorOptions &opts) : opts(opts)
+{
+    monitor.endpoint_ttl = opts.endpoint_ttl;
+    monitor.mem_cap = opts.mem_cap;
+    monitor.governor.budget = opts.cpu_budget;
+    // 抖动记录各占预算的 1/8，话题指标历史另占 1/8
+    monitor.node_flaps.max_records = monitor.endpoint_flaps.max_records =
+        opts.mem_cap / 8 / (sizeof(FlapRecord) + 4 * sizeof(void *));
+    monitor.reach.set_cache_limit(opts.mem_cap / 8);
+    if (opts.mem_cap)
+        monitor.max_topic_history = std::max<size_t>(opts.mem_cap / 8 / MonitorState::TOPIC_HISTORY_BYTES, 1);
+}
+
+bool Inspector::start(std::string *err)
+{
+    if (monitor.running)
+        return true;
+    if (opts.offline)
+    {
+        monitor.running = true;
+        Clock::enroll();
+        tasks.push_back(std::async(std::launch::async, task_heartbeat, &monitor, Guid{}, std::string{}, uint16_t{}, std::array<uint8_t, 4>{}, false));
+        return true;
+    }
+    if (opts.passive)
+    {
+        std::string reason;
+        PacketCapture cap(opts.capture_if, reason);
+        if (!cap.valid())
+        {
+            if (err)
+                *err = reason;
+            return false;
+        }
+        timestamps = true;
+        monitor.running = true;
+        tasks.push_back(std::async(std::launch::async, task_capture, &monitor, std::move(cap)));
+        Clock::enroll();
+        tasks.push_back(std::async(std::launch::async, task_heartbeat, &monitor, Guid{}, std::string{}, uint16_t{}, std::array<uint8_t, 4>{}, false));
+        return true;
+    }
+    UdpReceiver multicast_sock(RNDP_PORT, BROADCAST_IP); // RNDP 组播
+    UdpReceiver unicast_sock(0);                         // REDP 单播，端口随心跳通告
+    if (!multicast_sock.valid() || !unicast_sock.valid())
+    {
+        if (err)
+            *err = std::string("cannot bind ") + (multicast_sock.valid() ? "REDP" : "RNDP") + " socket: " + strerror(errno);
+        return false;
+    }
+    timestamps = multicast_sock.has_timestamps() && unicast_sock.has_timestamps();
+    uint16_t port = unicast_sock.port();
+    Guid guid;
+    guid.full = opts.guid;
+
+    monitor.running = true;
+    tasks.push_back(std::async(std::launch::async, task_nodes, &monitor, std::move(multicast_sock)));
+    tasks.push_back(std::async(std::launch::async, task_topics, &monitor, std::move(unicast_sock)));
+    Clock::enroll();
+    tasks.push_back(std::async(std::launch::async, task_heartbeat, &monitor, guid, opts.name, port, get_local_ip(), true));
+    return true;
+}
+
+void Inspector::stop()
+{
+    monitor.running = false;
+    for (auto &task : tasks)
+        task.wait();
+    tasks.clear();
+}
+
+Topology Inspector::topology()
+{
+    std::lock_guard<std::mutex> lock(monitor.mtx);
+    auto now = Clock::now();
+    Topology topo;
+    topo.nodes.reserve(monitor.nodes.size());
+    for (auto &[prefix, node] : monitor.nodes)
+    {
+        auto &hb = node.hb;
+        double age = hb.age(now);
+        topo.nodes.push_back({prefix, std::string(monitor.names.str(node.name_id)), age, hb.period, hb.jitter, hb.loss, node.held,
+                              node.held ? "HELD" : HeartbeatStats::health_of(age, hb.period, hb.jitter, hb.loss)});
+    }
+    for (auto &[prefix, endpoints] : monitor.topics)
+        for (auto &[guid, ep] : endpoints)
+            topo.endpoints.push_back({guid, prefix, std::string(monitor.names.str(ep.topic_id)), ep.is_pub, ep.held});
+    std::sort(topo.nodes.begin(), topo.nodes.end(), [](auto &a, auto &b) { return a.prefix < b.prefix; });
+    std::sort(topo.endpoints.begin(), topo.endpoints.end(), [](auto &a, auto &b) { return a.guid < b.guid; });
+    return topo;
+}
+
+void Inspector::inject(const Datagram &dgram)
+{
+    std::call_once(inject_once, [this] { inject_traffic = &monitor.traffic.attach(); });
+    ingest(&monitor, *inject_traffic, dgram);
+}
+
+size_t Inspector::subscribe(Callback cb)
+{
+    std::lock_guard<std::mutex> lock(monitor.mtx);
+    monitor.observers.emplace_back(monitor.next_observer, std::move(cb));
+    return monitor.next_observer++;
+}
+
+void Inspector::unsubscribe(size_t id)
+{
+    std::lock_guard<std::mutex> lock(monitor.mtx);
+    auto &obs = monitor.observers;
+    obs.erase(std::remove_if(obs.begin(), obs.end(), [id](auto &o) { return o.first == id; }), obs.end());
+}
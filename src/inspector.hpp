@@ -0,0 +1,140 @@
+/**
+ * @file inspector.hpp
+ * @author Nq139 (fnq409997@gmail.com)
+ * @brief 可嵌入的 LPSS 拓扑发现引擎
+ * @copyright Copyright 2026, Nq139
+ */
+
+#pragma once
+
+#include <future>
+#include <string>
+#include <vector>
+
+#include "monitor_state.hpp"
+
+struct Datagram;
+
+/**
+ * @brief 复制增量维护的节点列式视图并填充 `AGE` 列
+ * @param state 全局状态对象，调用方需持有 `state.mtx`
+ * @param now 计算节点年龄所用的当前时间
+ * @param with_topics 是否同时构建各节点的话题，仅按话题过滤时需要
+ */
+NodeColumns copy_columns(const MonitorState &state, Clock::time_point now, bool with_topics);
+
+/**
+ * @brief 对当前拓扑拍摄快照
+ * @param state 全局状态对象，调用方需持有 `state.mtx`
+ */
+Snapshot take_snapshot(MonitorState &state);
+
+//! 检查器配置
+struct InspectorOptions
+{
+    Clock::duration endpoint_ttl{};         //!< 端点超时时间，为 0 时端点仅随节点超时或显式撤销而移除
+    size_t mem_cap{};                       //!< 节点与端点的内存预算（字节），为 0 时不限制
+    double cpu_budget{};                    //!< CPU 预算，单核的比例，为 0 时不限制
+    uint64_t guid{0x12345678};              //!< 心跳通告中使用的 GUID
+    std::string name{"lpss_inspector"};     //!< 心跳通告中使用的节点名
+    bool passive{};                         //!< 被动模式：不绑定发现端口、不发送心跳，只从抓包中重建拓扑
+    std::string capture_if;                 //!< 被动模式抓包的网卡，空表示全部网卡
+    bool offline{};                         //!< 离线模式：不绑定发现端口、不抓包也不发送心跳，报文全部经 `inject()` 注入，只运行超时清理与历史采样
+};
+
+//! 自包含的拓扑副本，不引用检查器内部的任何数据
+struct Topology
+{
+    struct Node
+    {
+        uint64_t prefix;   //!< GUID 前缀
+        std::string name;  //!< 节点名
+        double age;        //!< 距最近一次通告的秒数
+        double period;     //!< 心跳周期估计（秒）
+        double jitter;     //!< 心跳抖动（秒）
+        double loss;       //!< 心跳丢失率
+        bool held;         //!< 是否因抖动抑制而保留
+        const char *health; //!< 健康状态
+    };
+
+    struct Endpoint
+    {
+        uint64_t guid;     //!< 端点 GUID
+        uint64_t node;     //!< 所属节点的 GUID 前缀
+        std::string topic; //!< 话题名
+        bool is_pub;       //!< 是否为发布者
+        bool held;         //!< 是否因抖动抑制而保留
+    };
+
+    std::vector<Node> nodes;         //!< 按 GUID 前缀升序
+    std::vector<Endpoint> endpoints; //!< 按端点 GUID 升序
+};
+
+/**
+ * @brief LPSS 拓扑发现引擎
+ * @details 监听 RNDP 组播与 REDP 单播报文、周期广播心跳并维护拓扑状态；被动模式下改为抓取其他节点之间的 RNDP 与 REDP
+ *          报文，自身不发送任何报文，只能看到其他节点之间实际交换过的端点。嵌入方通过 `topology()` 取得拓扑副本，
+ *          或以 `subscribe()` 订阅增量事件；需要完整内部状态（历史、抖动统计、可达性索引等）时，可在持有
+ *          `state().mtx` 期间直接读取 `state()`。同一进程只应创建一个实例，以免重复占用发现端口
+ */
+class Inspector
+{
+public:
+    using Callback = std::function<void(const TopologyEvent &)>;
+
+    explicit Inspector(const InspectorOptions &opts = {});
+    Inspector(const Inspector &) = delete;
+    Inspector &operator=(const Inspector &) = delete;
+    ~Inspector() { stop(); }
+
+    /**
+     * @brief 创建发现套接字（被动模式下为抓包环）并启动收包与心跳线程
+     * @param[out] err 失败原因
+     * @return 是否启动成功，已在运行时直接返回 `true`
+     */
+    bool start(std::string *err = nullptr);
+
+    //! 停止各线程并等待其退出，最长约 1 s
+    void stop();
+
+    //! 是否正在运行
+    bool running() const { return monitor.running; }
+
+    //! 内核是否为发现套接字提供接收时间戳
+    bool kernel_timestamps() const { return timestamps; }
+
+    //! 当前拓扑的副本
+    Topology topology();
+
+    /**
+     * @brief 订阅拓扑增量事件
+     * @note 回调在收包或心跳线程上、持有 `state().mtx` 时同步调用，应尽快返回，且不得调用本对象的方法。
+     *       事件中的名字只在回调期间有效
+     * @param[in] cb 回调
+     * @return 订阅 ID
+     */
+    size_t subscribe(Callback cb);
+
+    //! 取消订阅
+    void unsubscribe(size_t id);
+
+    /**
+     * @brief 在调用线程上同步处理一个数据报，如同从发现端口收到
+     * @details 供测试与回放注入报文，配合 `Clock::use_virtual()` 可得到确定的结果；首字节为 `N` 的报文按 RNDP
+     *          组播端口处理，其余按 REDP 单播端口处理。不要求已调用 `start()`
+     * @param[in] dgram 数据报，虚拟时间模式下以当前虚拟时间为到达时刻；与从套接字收到的报文一样，`dgram.data` 之后须有
+     *                  结尾的 `'\0'`，以 `std::string` 保存的报文即满足
+     */
+    void inject(const Datagram &dgram);
+
+    //! 内部状态，读写前须持有 `state().mtx`
+    MonitorState &state() { return monitor; }
+
+private:
+    InspectorOptions opts;
+    MonitorState monitor;
+    bool timestamps{};
+    std::once_flag inject_once;
+    TrafficStats::Shard *inject_traffic{}; //!< 注入报文的流量摘要分片
+    std::vector<std::future<void>> tasks;
+};
@@ -16,241 +16,1816 @@
 #include <thread>
 #include <atomic>
 #include <mutex>
-#include <array>
-#include <ifaddrs.h>
-#include <netinet/in.h>
 #include <set>
+#include <map>
+#include <string_view>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <functional>
+#include <condition_variable>
+#include <deque>
+#include <ctime>
+#include <poll.h>
+#include <fcntl.h>
+#include <climits>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <net/if.h>
 
-#include <rmvl/lpss.hpp>
-#include <rmvl/io/socket.hpp>
+#include "graph_layout.hpp"
+#include "inspector.hpp"
+#include "text_buffer.hpp"
+#include "metrics.hpp"
+#include "thread_placement.hpp"
+#include "web_ui.hpp"
 
-using namespace rm;
-using namespace rm::lpss;
 using namespace std::chrono_literals;
 
-
-struct EndpointInfo
+//! 转换为带引号的 JSON 字符串
+std::string json_quote(std::string_view s)
 {
-    std::string topic;
-    bool is_pub;
-};
+    std::string res = "\"";
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            res += '\\', res += c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            res += esc;
+        }
+        else
+            res += c;
+    }
+    return res + '"';
+}
 
 /**
- * @brief 全局监控状态
+ * @brief 告警分发器，在独立线程中将告警写入各输出端，不阻塞事件处理
+ * @details 输出端格式
+ * - `stdout`：标准输出
+ * - `file:<path>`：以 JSON Lines 格式追加写入文件
+ * - `exec:<command>`：每条告警执行一次命令，JSON 经标准输入传入，可作为 webhook 的替身，如 `exec:curl -d @- <url>`
  */
-struct MonitorState
+class AlertDispatcher
 {
+public:
+    AlertDispatcher() : worker([this] { run(); }) {}
+    AlertDispatcher(const AlertDispatcher &) = delete;
+    AlertDispatcher &operator=(const AlertDispatcher &) = delete;
+
+    ~AlertDispatcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_one();
+        worker.join();
+    }
+
+    //! 添加输出端，格式不合法时返回 `false`
+    bool add_sink(const std::string &spec)
+    {
+        if (spec != "stdout" && spec.compare(0, 5, "file:") && spec.compare(0, 5, "exec:"))
+            return false;
+        std::lock_guard<std::mutex> lock(mtx);
+        sinks.push_back(spec);
+        return true;
+    }
+
+    /**
+     * @brief 提交一条告警
+     * @param[in] text 文本形式
+     * @param[in] json JSON 形式
+     */
+    void post(std::string text, std::string json)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            queue.emplace_back(std::move(text), std::move(json));
+        }
+        posted.add();
+        queued.add(1);
+        cv.notify_one();
+    }
+
+private:
+    void run()
+    {
+        auto placed = ThreadPlacement::global().enter(ThreadPlacement::Exporter, "lpss-alerts");
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true)
+        {
+            cv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty())
+                return;
+            auto [text, json] = std::move(queue.front());
+            queue.pop_front();
+            auto targets = sinks.empty() ? std::vector<std::string>{"stdout"} : sinks;
+            lock.unlock();
+            queued.sub(1);
+            for (auto &sink : targets)
+            {
+                if (sink == "stdout")
+                    printf("%s\n", text.c_str()), fflush(stdout);
+                else if (FILE *fp = sink[0] == 'f' ? fopen(sink.c_str() + 5, "a") : popen(sink.c_str() + 5, "w"))
+                {
+                    fprintf(fp, "%s\n", json.c_str());
+                    sink[0] == 'f' ? fclose(fp) : pclose(fp);
+                }
+                else
+                {
+                    failed.add();
+                    continue;
+                }
+                delivered.add();
+            }
+            lock.lock();
+        }
+    }
+
     std::mutex mtx;
-    std::unordered_map<uint64_t, std::string> nodes;
-    std::unordered_map<uint64_t, std::vector<EndpointInfo>> topics;
-    std::atomic<bool> running{true};
+    std::condition_variable cv;
+    std::deque<std::pair<std::string, std::string>> queue;
+    std::vector<std::string> sinks;
+    bool stopping{};
+    MetricsRegistry::Counter posted = metrics().counter("alerts.posted");       //!< 提交的告警数
+    MetricsRegistry::Counter delivered = metrics().counter("alerts.delivered"); //!< 成功写入输出端的次数
+    MetricsRegistry::Counter failed = metrics().counter("alerts.sink_errors");  //!< 输出端打开失败的次数
+    MetricsRegistry::Gauge queued = metrics().gauge("alerts.queued");           //!< 待分发的告警数
+    std::thread worker;
 };
 
+/**
+ * @brief 拓扑健康规则引擎
+ * @details 规则语法（每条一行）
+ * - `topic <name|*> <pubs|subs> <op> <N>`：话题的发布者/订阅者数需满足比较条件，`op` 为 `<`、`<=`、`>`、`>=`、`==`、`!=`，
+ *   `*` 表示对每个话题分别检查
+ * - `node <name> alive`：名为 `name` 的节点需在线
+ *
+ * 规则在添加时编译为按话题名或节点名索引的谓词，引擎只维护各话题的端点计数与各节点名的在线计数。
+ * 每个增量事件只更新一个计数并求值以该话题/节点为索引的规则及通配规则，开销与变化量成正比而与网络规模无关。
+ * 计数以名字的 64 位哈希为键，不复制驻留表中已有的名字，只有正在违反规则的主体保存其名字。
+ * 规则在违反与恢复之间切换时分别触发 `FIRING` 与 `RESOLVED` 告警
+ */
+class RuleEngine
+{
+public:
+    explicit RuleEngine(AlertDispatcher &alerts) : alerts(alerts) {}
+
+    /**
+     * @brief 编译并添加一条规则，并以当前计数完成首次求值
+     * @param[in] text 规则文本
+     * @param[in] state 全局状态对象，调用方需持有 `state.mtx`，通配规则据此取得现有话题的名字
+     * @return 语法错误时返回 `false`
+     */
+    bool add(const std::string &text, const MonitorState &state)
+    {
+        char kind[16], target[128], field[16], op[4];
+        long value = 0;
+        Rule r{};
+        r.text = text;
+        if (sscanf(text.c_str(), "%15s %127s %15s %3s %ld", kind, target, field, op, &value) == 5 && !strcmp(kind, "topic"))
+        {
+            r.field = !strcmp(field, "pubs") ? 0 : !strcmp(field, "subs") ? 1 : -1;
+            r.op = compile_op(op);
+            r.value = value;
+            if (r.field < 0 || !r.op)
+                return false;
+        }
+        else if (sscanf(text.c_str(), "%15s %127s %15s", kind, target, field) == 3 && !strcmp(kind, "node") &&
+                 !strcmp(field, "alive"))
+            r.is_node = true;
+        else
+            return false;
+        r.target = target;
+
+        size_t idx = rules.size();
+        rules.push_back(std::move(r));
+        auto &rule = rules.back();
+        if (rule.is_node)
+        {
+            by_node[hash64(rule.target)].push_back(idx);
+            evaluate(idx, rule.target);
+        }
+        else if (rule.target == "*")
+        {
+            wildcard.push_back(idx);
+            std::unordered_set<uint32_t> seen;
+            for (auto &[prefix, endpoints] : state.topics)
+                for (auto &[guid, ep] : endpoints)
+                    if (seen.insert(ep.topic_id).second)
+                        evaluate(idx, state.names.str(ep.topic_id));
+        }
+        else
+        {
+            by_topic[hash64(rule.target)].push_back(idx);
+            evaluate(idx, rule.target);
+        }
+        return true;
+    }
+
+    //! 处理一个拓扑增量事件，需在持有 `MonitorState::mtx` 时调用
+    void on_event(const TopologyEvent &e)
+    {
+        using Kind = TopologyEvent::Kind;
+        switch (e.kind)
+        {
+        case Kind::NodeUp:
+        case Kind::NodeDown: {
+            uint64_t key = hash64(e.name);
+            int &alive = node_alive[key];
+            alive += e.kind == Kind::NodeUp ? 1 : -1;
+            if (alive <= 0)
+                node_alive.erase(key);
+            auto it = by_node.find(key);
+            if (it != by_node.end())
+                for (size_t idx : it->second)
+                    if (rules[idx].target == e.name) // 排除哈希碰撞
+                        evaluate(idx, e.name);
+            break;
+        }
+        case Kind::EndpointAdded:
+        case Kind::EndpointRemoved: {
+            uint64_t key = hash64(e.topic);
+            auto &c = topic_counts[key];
+            (e.is_pub ? c.first : c.second) += e.kind == Kind::EndpointAdded ? 1 : -1;
+            // 话题已消失时通配规则不再跟踪该话题，而指名规则照常以计数 0 求值
+            bool gone = c.first <= 0 && c.second <= 0;
+            if (gone)
+                topic_counts.erase(key);
+            auto it = by_topic.find(key);
+            if (it != by_topic.end())
+                for (size_t idx : it->second)
+                    if (rules[idx].target == e.topic)
+                        evaluate(idx, e.topic);
+            for (size_t idx : wildcard)
+                evaluate(idx, e.topic, gone);
+            break;
+        }
+        }
+    }
+
+    //! 将全部规则及其状态写入 `out`
+    void print(TextBuffer &out) const
+    {
+        for (auto &r : rules)
+        {
+            out.put("  ").pad(r.text, 40).put(' ');
+            if (r.target == "*" && !r.is_node)
+                out.num(r.violating.size()).put(" violating\n");
+            else
+                out.put(r.violating.empty() ? "ok\n" : "VIOLATED\n");
+        }
+    }
+
+private:
+    using Op = bool (*)(long, long);
+
+    struct Rule
+    {
+        std::string text;
+        std::string target;
+        bool is_node{};
+        int field{};                     //!< 0 为发布者数，1 为订阅者数
+        Op op{};
+        long value{};
+        std::set<std::string, std::less<>> violating; //!< 当前违反该规则的话题或节点名
+    };
+
+    static Op compile_op(const char *op)
+    {
+        static const std::pair<const char *, Op> OPS[] = {
+            {"<", [](long a, long b) { return a < b; }},   {"<=", [](long a, long b) { return a <= b; }},
+            {">", [](long a, long b) { return a > b; }},   {">=", [](long a, long b) { return a >= b; }},
+            {"==", [](long a, long b) { return a == b; }}, {"!=", [](long a, long b) { return a != b; }},
+        };
+        for (auto &[name, fn] : OPS)
+            if (!strcmp(name, op))
+                return fn;
+        return nullptr;
+    }
+
+    /**
+     * @brief 对单个主体求值规则，状态切换时发出告警
+     * @param[in] idx 规则下标
+     * @param[in] subject 话题名或节点名
+     * @param[in] gone 主体已消失：不再求值，仍处于违反状态时以 `RESOLVED` 告警结束跟踪
+     */
+    void evaluate(size_t idx, std::string_view subject, bool gone = false)
+    {
+        auto &r = rules[idx];
+        long actual;
+        bool ok;
+        if (gone)
+        {
+            actual = 0;
+            ok = true;
+        }
+        else if (r.is_node)
+        {
+            auto it = node_alive.find(hash64(subject));
+            actual = it != node_alive.end() ? it->second : 0;
+            ok = actual > 0;
+        }
+        else
+        {
+            auto it = topic_counts.find(hash64(subject));
+            actual = it == topic_counts.end() ? 0 : r.field == 0 ? it->second.first : it->second.second;
+            ok = r.op(actual, r.value);
+        }
+        auto violated = r.violating.find(subject);
+        if (ok == (violated == r.violating.end()))
+            return;
+        ok ? (void)r.violating.erase(violated) : (void)r.violating.emplace(subject);
+
+        char when[32];
+        time_t t = time(nullptr);
+        tm local; // 本函数在收包线程上调用，localtime 的静态缓冲区会与其他线程竞争
+        strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%S", localtime_r(&t, &local));
+        const char *status = ok ? "RESOLVED" : "FIRING";
+        std::string text = std::string("[") + when + "] " + status + " " + r.text + " (" + std::string(subject) + " = " +
+                           std::to_string(actual) + ")";
+        std::string json = std::string("{\"time\":\"") + when + "\",\"status\":\"" + status + "\",\"rule\":" +
+                           json_quote(r.text) + ",\"subject\":" + json_quote(subject) + ",\"value\":" + std::to_string(actual) + "}";
+        alerts.post(std::move(text), std::move(json));
+    }
 
-inline uint64_t get_prefix(const Guid &g) { return g.full & 0xFFFFFFFFFFFFULL; }
+    AlertDispatcher &alerts;
+    std::vector<Rule> rules;
+    std::unordered_map<uint64_t, std::vector<size_t>> by_topic;       //!< 话题名哈希 -> 规则
+    std::unordered_map<uint64_t, std::vector<size_t>> by_node;        //!< 节点名哈希 -> 规则
+    std::vector<size_t> wildcard;                                     //!< 对每个话题检查的规则
+    std::unordered_map<uint64_t, std::pair<long, long>> topic_counts; //!< 话题名哈希 -> (发布者数, 订阅者数)
+    std::unordered_map<uint64_t, int> node_alive;                     //!< 节点名哈希 -> 在线节点数
+};
 
 /**
- * @brief Get the local ip object
- * @return std::array<uint8_t, 4>
+ * @brief 编译后的节点过滤表达式
+ * @details 语法示例：`name~"cam*" && pubs>3 && age<5s`
+ * - 字符串字段 `name`、`topic`（节点任一端点的话题）支持 `~`、`!~`（glob 匹配）与 `==`、`!=`
+ * - 数值字段 `pubs`、`subs`、`eps`、`age`、`period`、`jitter`、`loss`、`held` 支持 `<`、`<=`、`>`、`>=`、`==`、`!=`，
+ *   数值可带 `ms`、`s`、`m`、`h`、`%` 后缀，单独的 `held` 等价于 `held!=0`
+ * - 支持 `&&`、`||`、`!` 与括号
+ *
+ * 表达式只编译一次为后缀形式的指令序列，求值时每条指令处理整列并产生选择掩码；字符串谓词按驻留 ID 记忆化，
+ * 每个不同的名字只匹配一次
  */
-std::array<uint8_t, 4> get_local_ip()
+class NodeFilter
 {
-    std::array<uint8_t, 4> res = {0};
-    struct ifaddrs *ifa;
-    getifaddrs(&ifa);
-    for (auto *p = ifa; p; p = p->ifa_next)
+public:
+    /**
+     * @brief 编译过滤表达式
+     * @param[in] text 表达式文本，空串表示不过滤
+     * @param[out] err 语法错误信息
+     * @return 是否编译成功
+     */
+    bool compile(const char *text, std::string &err)
+    {
+        code.clear();
+        p = text;
+        skip();
+        if (!*p)
+            return true;
+        if (!parse_or())
+        {
+            err = error + " at '" + std::string(p).substr(0, 16) + "'";
+            return false;
+        }
+        skip();
+        if (*p)
+        {
+            err = "unexpected '" + std::string(p).substr(0, 16) + "'";
+            return false;
+        }
+        return true;
+    }
+
+    //! 表达式是否为空（选择全部节点）
+    bool empty() const { return code.empty(); }
+
+    //! 表达式是否含话题谓词，含有时求值所用的列式视图需带有各节点的话题
+    bool uses_topics() const
+    {
+        return std::any_of(code.begin(), code.end(), [](const Insn &insn) { return insn.op == Op::Topic; });
+    }
+
+    //! 各字符串谓词在驻留表上的匹配结果，按字符串谓词在指令序列中的顺序排列，以 ID 为下标
+    using Memo = std::vector<std::vector<uint8_t>>;
+
+    /**
+     * @brief 在驻留表上求出各字符串谓词匹配的 ID
+     * @note 只有这一步需要访问驻留表，调用方在持有状态锁时完成，其余求值可在释放锁之后进行
+     * @param[in] pool 驻留表
+     */
+    Memo bind(const StringPool &pool) const
+    {
+        Memo memos;
+        for (auto &insn : code)
+        {
+            if (insn.op != Op::Name && insn.op != Op::Topic)
+                continue;
+            // 对驻留表一次扫描得到全部匹配的 ID，各行只需查表
+            auto &memo = memos.emplace_back(pool.size());
+            if (insn.cmp == Cmp::EQ || insn.cmp == Cmp::NE)
+            {
+                uint32_t id = pool.lookup(insn.glob.pattern);
+                if (id != UINT32_MAX)
+                    memo[id] = 1;
+            }
+            else
+                for (uint32_t id : pool.glob(insn.glob))
+                    memo[id] = 1;
+        }
+        return memos;
+    }
+
+    /**
+     * @brief 对列式视图求值
+     * @param[in] cols 节点列式视图，含话题谓词时需带有各节点的话题
+     * @param[in] memos 与 `cols` 同时取得的 `bind` 结果
+     * @return 选择掩码，选中的行为 1
+     */
+    std::vector<uint8_t> eval(const NodeColumns &cols, const Memo &memos) const
     {
-        if (p->ifa_addr && p->ifa_addr->sa_family == AF_INET && strcmp(p->ifa_name, "lo") != 0)
+        size_t n = cols.size();
+        if (code.empty())
+            return std::vector<uint8_t>(n, 1);
+        std::vector<std::vector<uint8_t>> stack;
+        auto next_memo = memos.begin();
+        for (auto &insn : code)
         {
-            memcpy(res.data(), &((struct sockaddr_in *)p->ifa_addr)->sin_addr.s_addr, 4);
+            switch (insn.op)
+            {
+            case Op::Num:
+                stack.push_back(compare(cols.num[insn.field], insn.cmp, insn.value));
+                break;
+            case Op::Name:
+            case Op::Topic: {
+                auto &memo = *next_memo++;
+                bool negate = insn.cmp == Cmp::NE || insn.cmp == Cmp::NMATCH;
+                std::vector<uint8_t> m(n);
+                if (insn.op == Op::Name)
+                    for (size_t i = 0; i < n; i++)
+                        m[i] = memo[cols.name[i]] ^ negate;
+                else
+                    for (size_t i = 0; i < n; i++)
+                    {
+                        uint8_t any = 0;
+                        for (uint32_t k = cols.topic_begin[i]; k < cols.topic_begin[i + 1]; k++)
+                            any |= memo[cols.topics[k]];
+                        m[i] = any ^ negate;
+                    }
+                stack.push_back(std::move(m));
+                break;
+            }
+            case Op::Not:
+                for (auto &x : stack.back())
+                    x ^= 1;
+                break;
+            case Op::And:
+            case Op::Or: {
+                auto b = std::move(stack.back());
+                stack.pop_back();
+                auto &a = stack.back();
+                if (insn.op == Op::And)
+                    for (size_t i = 0; i < n; i++)
+                        a[i] &= b[i];
+                else
+                    for (size_t i = 0; i < n; i++)
+                        a[i] |= b[i];
+                break;
+            }
+            }
+        }
+        return std::move(stack.back());
+    }
+
+private:
+    enum class Op : uint8_t
+    {
+        Num,   //!< 数值列比较
+        Name,  //!< 节点名匹配
+        Topic, //!< 任一话题匹配
+        And,
+        Or,
+        Not,
+    };
+
+    enum class Cmp : uint8_t
+    {
+        LT,
+        LE,
+        GT,
+        GE,
+        EQ,
+        NE,
+        MATCH,
+        NMATCH,
+    };
+
+    struct Insn
+    {
+        Op op;
+        Cmp cmp{};
+        uint8_t field{};
+        double value{};
+        GlobPattern glob; //!< 字符串谓词的模式，`==`/`!=` 时只使用其原始模式
+    };
+
+    //! 整列比较，循环体内无分支以便编译器向量化
+    static std::vector<uint8_t> compare(const std::vector<double> &col, Cmp cmp, double v)
+    {
+        size_t n = col.size();
+        std::vector<uint8_t> m(n);
+        const double *x = col.data();
+        switch (cmp)
+        {
+        case Cmp::LT:
+            for (size_t i = 0; i < n; i++)
+                m[i] = x[i] < v;
+            break;
+        case Cmp::LE:
+            for (size_t i = 0; i < n; i++)
+                m[i] = x[i] <= v;
+            break;
+        case Cmp::GT:
+            for (size_t i = 0; i < n; i++)
+                m[i] = x[i] > v;
+            break;
+        case Cmp::GE:
+            for (size_t i = 0; i < n; i++)
+                m[i] = x[i] >= v;
+            break;
+        case Cmp::EQ:
+            for (size_t i = 0; i < n; i++)
+                m[i] = x[i] == v;
+            break;
+        default:
+            for (size_t i = 0; i < n; i++)
+                m[i] = x[i] != v;
             break;
         }
+        return m;
     }
-    if (ifa)
-        freeifaddrs(ifa);
-    return res;
-}
 
+    void skip() { p += strspn(p, " \t\r\n"); }
+
+    bool accept(const char *tok)
+    {
+        skip();
+        size_t len = strlen(tok);
+        if (strncmp(p, tok, len))
+            return false;
+        p += len;
+        return true;
+    }
+
+    bool fail(const char *msg) { return error = msg, false; }
+
+    bool parse_or()
+    {
+        if (!parse_and())
+            return false;
+        while (accept("||"))
+        {
+            if (!parse_and())
+                return false;
+            code.push_back({Op::Or});
+        }
+        return true;
+    }
+
+    bool parse_and()
+    {
+        if (!parse_unary())
+            return false;
+        while (accept("&&"))
+        {
+            if (!parse_unary())
+                return false;
+            code.push_back({Op::And});
+        }
+        return true;
+    }
+
+    bool parse_unary()
+    {
+        skip();
+        if (p[0] == '!' && p[1] != '=' && p[1] != '~')
+        {
+            p++;
+            if (!parse_unary())
+                return false;
+            code.push_back({Op::Not});
+            return true;
+        }
+        if (accept("("))
+        {
+            if (!parse_or())
+                return false;
+            return accept(")") || fail("missing ')'");
+        }
+        return parse_cmp();
+    }
+
+    bool parse_cmp()
+    {
+        static const std::pair<const char *, uint8_t> NUMERIC[] = {
+            {"pubs", NodeColumns::PUBS}, {"subs", NodeColumns::SUBS},       {"eps", NodeColumns::EPS},
+            {"age", NodeColumns::AGE},   {"period", NodeColumns::PERIOD},   {"jitter", NodeColumns::JITTER},
+            {"loss", NodeColumns::LOSS}, {"held", NodeColumns::HELD},
+        };
+        static const std::pair<const char *, Cmp> CMPS[] = {
+            {"!~", Cmp::NMATCH}, {"==", Cmp::EQ}, {"!=", Cmp::NE}, {"<=", Cmp::LE},
+            {">=", Cmp::GE},     {"~", Cmp::MATCH}, {"<", Cmp::LT}, {">", Cmp::GT},
+        };
+        skip();
+        size_t len = strspn(p, "abcdefghijklmnopqrstuvwxyz");
+        std::string field(p, len);
+        p += len;
+
+        Insn insn{Op::Num};
+        if (field == "name" || field == "topic")
+            insn.op = field == "name" ? Op::Name : Op::Topic;
+        else
+        {
+            auto it = std::find_if(std::begin(NUMERIC), std::end(NUMERIC), [&](auto &f) { return field == f.first; });
+            if (it == std::end(NUMERIC))
+                return fail("unknown field");
+            insn.field = it->second;
+        }
+
+        auto cmp = std::find_if(std::begin(CMPS), std::end(CMPS), [&](auto &c) { return accept(c.first); });
+        if (cmp == std::end(CMPS))
+        {
+            if (insn.field != NodeColumns::HELD || insn.op != Op::Num)
+                return fail("expected comparison operator");
+            insn.cmp = Cmp::NE;
+            code.push_back(std::move(insn));
+            return true;
+        }
+        insn.cmp = cmp->second;
+        bool is_string = insn.op != Op::Num;
+        bool is_match = insn.cmp == Cmp::MATCH || insn.cmp == Cmp::NMATCH;
+        if (is_string ? !(is_match || insn.cmp == Cmp::EQ || insn.cmp == Cmp::NE) : is_match)
+            return fail("operator not applicable to field");
+
+        skip();
+        if (is_string)
+        {
+            size_t vlen;
+            const char *begin = p;
+            if (*p == '"')
+            {
+                const char *end = strchr(++begin, '"');
+                if (!end)
+                    return fail("unterminated string");
+                vlen = end - begin;
+                p = end + 1;
+            }
+            else
+                p += vlen = strcspn(p, " \t\r\n&|()");
+            insn.glob = GlobPattern(std::string(begin, vlen));
+        }
+        else
+        {
+            char *end;
+            insn.value = strtod(p, &end);
+            if (end == p)
+                return fail("expected number");
+            p = end;
+            static const std::pair<const char *, double> UNITS[] = {{"ms", 1e-3}, {"s", 1}, {"m", 60}, {"h", 3600}, {"%", 0.01}};
+            for (auto &[unit, scale] : UNITS)
+                if (!strncmp(p, unit, strlen(unit)))
+                {
+                    insn.value *= scale;
+                    p += strlen(unit);
+                    break;
+                }
+        }
+        code.push_back(std::move(insn));
+        return true;
+    }
+
+    std::vector<Insn> code; //!< 后缀形式的指令序列
+    const char *p{};        //!< 解析位置
+    std::string error;      //!< 解析错误
+};
 
 /**
- * @brief 持续监听 RNDP 报文，收集网络中节点的信息
+ * @brief 将 iovec 数组全部写入文件描述符，处理部分写入
+ * @return 是否全部写入成功
  */
-void task_nodes(MonitorState *state)
+bool writev_all(int fd, std::vector<iovec> &iov)
 {
-    auto sock = rm::Listener(rm::Endpoint(rm::ip::udp::v4(), 7500)).create();
-    sock.setOption(rm::ip::multicast::JoinGroup(BROADCAST_IP));
-    while (state->running)
+    for (size_t i = 0; i < iov.size();)
     {
-        auto [data, addr, port] = sock.read(); // 持续监听
-        if (data.size() >= 14 && data[0] == 'N')
+        ssize_t n = writev(fd, iov.data() + i, static_cast<int>(std::min<size_t>(iov.size() - i, IOV_MAX)));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        // 跳过已完整写出的段，并截去部分写出的段的前缀
+        size_t done = n;
+        while (i < iov.size() && done >= iov[i].iov_len)
+            done -= iov[i++].iov_len;
+        if (i < iov.size())
         {
-            auto msg = RNDPMessage::deserialize(data.data());
-            std::lock_guard<std::mutex> lock(state->mtx);
-            state->nodes[get_prefix(msg.guid)] = msg.name;
+            iov[i].iov_base = static_cast<char *>(iov[i].iov_base) + done;
+            iov[i].iov_len -= done;
         }
     }
+    return true;
+}
+
+/**
+ * @brief 将 `[0, count)` 均分为若干分片并行执行 `fn(shard, begin, end)`
+ * @note 规模较小时只使用一个分片并在当前线程执行
+ * @return 分片数
+ */
+template <typename Fn>
+size_t parallel_shards(size_t count, size_t min_per_shard, Fn &&fn)
+{
+    size_t shards = std::clamp<size_t>(count / min_per_shard, 1, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::future<void>> futs;
+    for (size_t k = 1; k < shards; k++)
+        futs.push_back(std::async(std::launch::async, [&, k] {
+            auto placed = ThreadPlacement::global().enter(ThreadPlacement::Render, "lpss-graph");
+            fn(k, count * k / shards, count * (k + 1) / shards);
+        }));
+    fn(0, 0, count / shards);
+    for (auto &f : futs)
+        f.get();
+    return shards;
 }
 
 /**
- * @brief 持续监听 REDP 报文，收集网络中节点的发布/订阅话题信息
+ * @brief 生成图形化的网络拓扑结构
+ * @param state 全局状态对象
+ * @param filter 节点过滤表达式，非空时只绘制选中的节点及其话题
+ * @param layout 跨多次渲染保留的布局，各顶点坐标以 `pos` 属性写出并由 `neato -n2` 直接采用
+ * @param out 输出缓冲区
+ * @note 话题与节点按固定顺序分片，各分片并行格式化到各自的缓冲区，再按分片顺序以 `writev` 一次写出，
+ *       输出与逐行串行生成的结果逐字节一致。布局在释放锁之后求解，坐标以属性重述的形式追加在图的末尾
  */
-void task_topics(MonitorState *state, rm::DgramSocket &&sock)
+void generate_graph(MonitorState &state, const NodeFilter &filter, GraphLayout &layout, TextBuffer &out)
 {
-    while (state->running)
+    // 每个分片至少包含的节点（话题）数，过小时线程开销超过格式化本身
+    constexpr size_t MIN_PER_SHARD = 2048;
+
+    std::vector<TextBuffer> topic_bufs, node_bufs;
+    std::vector<std::string> topic_names;             // 话题顶点位于 `ids` 前部，节点顶点随后
+    std::vector<uint64_t> ids;                        // 布局顶点标识
+    std::vector<std::pair<uint32_t, uint32_t>> edges; // 节点 -> 话题
     {
-        auto [data, addr, port] = sock.read();
-        if (data.size() >= 14 && data[0] == 'E')
+        std::lock_guard<std::mutex> lock(state.mtx);
+        std::unordered_map<uint64_t, bool> selected;
+        if (!filter.empty())
+        {
+            auto cols = copy_columns(state, Clock::now(), filter.uses_topics());
+            auto mask = filter.eval(cols, filter.bind(state.names));
+            for (size_t i = 0; i < cols.size(); i++)
+                if (mask[i])
+                    selected[cols.prefix[i]] = true;
+        }
+        auto shown = [&](uint64_t prefix) { return filter.empty() || selected.count(prefix); };
+
+        // 1. topic (椭圆节点)
+        std::set<std::string_view> topic_set;
+        for (auto &pair : state.topics)
         {
-            auto msg = REDPMessage::deserialize(data.data());
-            std::lock_guard<std::mutex> lock(state->mtx);
-            auto &list = state->topics[get_prefix(msg.endpoint_guid)];
-            bool is_pub = (msg.type == REDPMessage::Type::Writer);
-            bool exists = false;
-            for (auto &ep : list)
-                if (ep.topic == msg.topic && ep.is_pub == is_pub)
-                    exists = true;
-            if (!exists)
-                list.push_back({msg.topic, is_pub});
+            if (!shown(pair.first))
+                continue;
+            for (auto &[guid, ep] : pair.second)
+                topic_set.insert(state.names.str(ep.topic_id));
         }
+        std::vector<std::string_view> all_topics(topic_set.begin(), topic_set.end());
+        std::unordered_map<std::string_view, uint32_t> topic_index;
+        for (auto topic : all_topics)
+        {
+            topic_index.emplace(topic, static_cast<uint32_t>(ids.size()));
+            ids.push_back(hash64(topic) | (1ULL << 63)); // 最高位区分话题与节点（GUID 前缀仅 48 位）
+            topic_names.emplace_back(topic);
+        }
+
+        // 2. 节点及其端点，保持哈希表的遍历顺序
+        std::vector<std::pair<uint64_t, const NodeInfo *>> nodes;
+        nodes.reserve(state.nodes.size());
+        for (auto &[prefix, node] : state.nodes)
+            if (shown(prefix))
+                nodes.emplace_back(prefix, &node);
+        for (auto &[prefix, node] : nodes)
+        {
+            auto v = static_cast<uint32_t>(ids.size());
+            ids.push_back(prefix);
+            auto it = state.topics.find(prefix);
+            if (it != state.topics.end())
+                for (auto &[guid, ep] : it->second)
+                    edges.emplace_back(v, topic_index[state.names.str(ep.topic_id)]);
+        }
+
+        topic_bufs.resize(std::max(1u, std::thread::hardware_concurrency()));
+        node_bufs.resize(topic_bufs.size());
+        size_t n = parallel_shards(all_topics.size(), MIN_PER_SHARD, [&](size_t k, size_t begin, size_t end) {
+            auto &out = topic_bufs[k];
+            for (size_t i = begin; i < end; i++)
+                out.put("  \"t_").put(all_topics[i]).put("\" [label=\"").put(all_topics[i])
+                    .put("\", shape=ellipse, style=filled, fillcolor=lightyellow];\n");
+        });
+        topic_bufs.resize(n);
+        n = parallel_shards(nodes.size(), MIN_PER_SHARD, [&](size_t k, size_t begin, size_t end) {
+            auto &out = node_bufs[k];
+            for (size_t i = begin; i < end; i++)
+            {
+                auto [prefix, node] = nodes[i];
+                // Node ：蓝色方框
+                out.put("  n").hex(prefix).put(" [label=\"").put(state.names.str(node->name_id))
+                    .put("\", shape=box, style=filled, fillcolor=lightblue];\n");
+                auto it = state.topics.find(prefix);
+                if (it == state.topics.end())
+                    continue;
+                for (auto &[guid, ep] : it->second)
+                {
+                    auto topic = state.names.str(ep.topic_id);
+                    if (ep.is_pub) // 发布者：节点 -> 话题 (蓝色箭头)
+                        out.put("  n").hex(prefix).put(" -> \"t_").put(topic).put("\" [color=blue, label=\"pub\"];\n");
+                    else // 订阅者：话题 -> 节点 (绿色箭头)
+                        out.put("  \"t_").put(topic).put("\" -> n").hex(prefix).put(" [color=darkgreen, label=\"sub\"];\n");
+                }
+            }
+        });
+        node_bufs.resize(n);
     }
+
+    auto pos = layout.layout(ids, edges);
+    std::vector<TextBuffer> pos_bufs(1);
+    auto &pos_buf = pos_bufs[0];
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        if (i < topic_names.size())
+            pos_buf.put("  \"t_").put(topic_names[i]).put('"');
+        else
+            pos_buf.put("  n").hex(ids[i]);
+        pos_buf.put(" [pos=\"").fixed(pos[i].x, 1).put(',').fixed(pos[i].y, 1).put("!\"];\n");
+    }
+    layout.save("lpss_graph.layout");
+    auto &ls = layout.stats();
+    out.put("layout: ").num(ls.vertices).put(" vertices, ").num(ls.active).put(ls.cold ? " placed (cold start), " : " moved, ");
+    out.fixed(ls.ms, 1).put(" ms\n");
+
+    static const char HEADER[] = "digraph G {\n  node [fontname=\"sans-serif\", fontsize=10];\n\n";
+    static const char FOOTER[] = "}\n";
+    std::vector<iovec> iov{{const_cast<char *>(HEADER), sizeof(HEADER) - 1}};
+    for (auto *bufs : {&topic_bufs, &node_bufs, &pos_bufs})
+        for (auto &b : *bufs)
+            iov.push_back({const_cast<char *>(b.view().data()), b.view().size()});
+    iov.push_back({const_cast<char *>(FOOTER), sizeof(FOOTER) - 1});
+
+    int fd = open("lpss_graph.dot", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return;
+    bool ok = writev_all(fd, iov);
+    close(fd);
+    if (!ok)
+        return;
+
+    system("neato -n2 -Tpng lpss_graph.dot -o lpss_graph.png && xdg-open lpss_graph.png > /dev/null 2>&1 &");///打开图片
 }
 
+/**
+ * @brief 输出满足过滤条件的节点
+ * @param state 全局状态对象
+ * @param filter 节点过滤表达式
+ * @param out 输出缓冲区
+ */
+void print_nodes(MonitorState &state, const NodeFilter &filter, TextBuffer &out)
+{
+    NodeColumns cols;
+    NodeFilter::Memo memos;
+    StringPool::View names;
+    {
+        // 持锁期间只做复制与驻留表上的谓词匹配，求值与格式化在释放锁之后进行，不阻塞收包线程
+        std::lock_guard<std::mutex> lock(state.mtx);
+        cols = copy_columns(state, Clock::now(), filter.uses_topics());
+        memos = filter.bind(state.names);
+        names = state.names.view();
+    }
+    auto mask = filter.eval(cols, memos);
+    auto &num = cols.num;
+    for (size_t i = 0; i < cols.size(); i++)
+    {
+        if (!mask[i])
+            continue;
+        double age = num[NodeColumns::AGE][i], period = num[NodeColumns::PERIOD][i];
+        double jitter = num[NodeColumns::JITTER][i], loss = num[NodeColumns::LOSS][i];
+        out.put("- ").pad(names.str(cols.name[i]), 24);
+        out.put(" period=").fixed(period, 2).put("s jitter=").fixed(jitter * 1e3, 0);
+        out.put("ms loss=").fixed(loss * 100, 0).put("% age=").fixed(age, 1).put("s ");
+        out.put(num[NodeColumns::HELD][i] ? "HELD" : HeartbeatStats::health_of(age, period, jitter, loss)).put('\n');
+    }
+}
 
 /**
- * @brief 定期广播 RNDP 心跳，诱导网络中的 LPSS 节点回应其存在
+ * @brief 每秒刷新输出满足过滤条件的节点，直至输入回车
+ * @param state 全局状态对象
+ * @param filter 节点过滤表达式
+ * @param out 输出缓冲区
  */
-void task_heartbeat(MonitorState *state, Guid my_guid, uint16_t port, std::array<uint8_t, 4> ip)
+void watch_nodes(MonitorState &state, const NodeFilter &filter, TextBuffer &out)
 {
-    auto sender = rm::Sender(rm::ip::udp::v4()).create();
-    while (state->running)
+    char line[256];
+    while (true)
     {
-        RNDPMessage msg;
-        msg.guid = my_guid;
-        msg.name = "lpss_inspector";
-        msg.locators.push_back({port, ip});
-        sender.write(BROADCAST_IP, rm::Endpoint(rm::ip::udp::v4(), 7500), msg.serialize());
-        std::this_thread::sleep_for(1s);
+        time_t t = time(nullptr);
+        tm local;
+        char when[16];
+        strftime(when, sizeof(when), "%H:%M:%S", localtime_r(&t, &local));
+        out.put("\n--- ").put(when).put(" (press Enter to stop) ---\n");
+        print_nodes(state, filter, out);
+        out.flush(false);
+        pollfd pfd{0, POLLIN, 0};
+        // CPU 超出预算时放宽刷新间隔
+        if (poll(&pfd, 1, state.governor.level() >= CpuGovernor::Refresh ? 5000 : 1000) > 0)
+        {
+            if (!fgets(line, sizeof(line), stdin))
+                return;
+            break;
+        }
     }
 }
 
+//! 命令名之后的参数文本，已去除首尾空白
+char *command_tail(char *buf)
+{
+    char *p = buf + strspn(buf, " \t");
+    p += strcspn(p, " \t\r\n");
+    p += strspn(p, " \t");
+    p[strcspn(p, "\r\n")] = '\0';
+    return p;
+}
+
+/**
+ * @brief 按子串或 glob 模式检索节点名与话题名
+ * @param state 全局状态对象
+ * @param pattern 不含通配符时按子串检索，否则按 glob 模式匹配
+ * @param out 输出缓冲区
+ */
+void find_names(MonitorState &state, const char *pattern, TextBuffer &out)
+{
+    std::lock_guard<std::mutex> lock(state.mtx);
+    auto &pool = state.names;
+    auto ids = strpbrk(pattern, "*?[") ? pool.glob(GlobPattern(pattern)) : pool.find(pattern);
+    std::vector<uint8_t> hit(pool.size());
+    for (uint32_t id : ids)
+        hit[id] = 1;
+
+    std::set<std::string_view> nodes, topics;
+    for (auto &[prefix, node] : state.nodes)
+        if (hit[node.name_id])
+            nodes.insert(pool.str(node.name_id));
+    for (auto &[prefix, endpoints] : state.topics)
+        for (auto &[guid, ep] : endpoints)
+            if (hit[ep.topic_id])
+                topics.insert(pool.str(ep.topic_id));
+    for (auto name : nodes)
+        out.put("  node  ").put(name).put('\n');
+    for (auto name : topics)
+        out.put("  topic ").put(name).put('\n');
+    out.num(nodes.size()).put(" nodes, ").num(topics.size()).put(" topics\n");
+}
 
 /**
- * @brief 生成图形化的网络拓扑结构
+ * @brief 输出全网与各节点的抖动统计
  * @param state 全局状态对象
+ * @param out 输出缓冲区
  */
-void generate_graph(MonitorState &state)
+void print_churn(MonitorState &state, TextBuffer &out)
 {
     std::lock_guard<std::mutex> lock(state.mtx);
-    FILE *fp = fopen("lpss_graph.dot", "w");
+    auto now = Clock::now();
+    size_t held = 0;
+    for (auto &[p, node] : state.nodes)
+        held += node.held;
+    out.format("network: appear=%.1f/min expire=%.1f/min (total %lu/%lu), restarts=%lu, held=%zu, flapping=%zu\n",
+               state.appear_rate.per_minute(now), state.expire_rate.per_minute(now),
+               state.appear_total, state.expire_total, state.restart_total, held, state.node_flaps.records.size());
+
+    std::vector<std::pair<uint64_t, FlapRecord *>> flapping;
+    for (auto &[key, r] : state.node_flaps.records)
+        flapping.emplace_back(key, &r);
+    std::sort(flapping.begin(), flapping.end(), [](auto &a, auto &b) { return a.second->penalty > b.second->penalty; });
+    for (auto &[key, r] : flapping)
+    {
+        auto it = state.nodes.find(key);
+        out.put("  ").pad(it != state.nodes.end() ? state.names.str(it->second.name_id) : "(gone)", 24);
+        out.put(" flaps=").num(r->flaps).put(" rate=").fixed(r->rate.per_minute(now), 1);
+        out.put("/min penalty=").fixed(r->penalty, 0).put(' ').put(r->suppressed ? "SUPPRESSED\n" : "\n");
+    }
+}
+
+/**
+ * @brief 输出发现流量的概率摘要
+ * @param state 全局状态对象
+ * @param n 参数个数（含命令名）
+ * @param args 命令参数，`traffic` 输出汇总，`traffic <ip:port> [topic]` 查询单个来源在某话题上的字节数
+ * @param out 输出缓冲区
+ */
+void print_traffic(MonitorState &state, int n, char args[][64], TextBuffer &out)
+{
+    size_t shards = state.traffic.size();
+    auto t = state.traffic.merged();
+    if (n >= 2)
+    {
+        char *colon = strrchr(args[1], ':');
+        in_addr addr{};
+        if (!colon || (*colon = '\0', inet_pton(AF_INET, args[1], &addr) != 1))
+        {
+            out.put("Usage: traffic [<ip>:<port> [topic]]\n");
+            return;
+        }
+        uint64_t source = TrafficSketch::source_key(addr.s_addr, static_cast<uint16_t>(atoi(colon + 1)));
+        std::string_view topic = n >= 3 ? args[2] : "";
+        uint64_t bound = static_cast<uint64_t>(t->bytes.epsilon() * t->bytes.sum());
+        out.put("bytes: <= ").num(t->bytes.estimate(TrafficSketch::flow_key(source, topic)));
+        out.put(" (at most ").num(bound).put(" over the true count with probability ");
+        out.fixed((1 - t->bytes.delta()) * 100, 1).put("%)\n");
+        return;
+    }
+    out.put("traffic: ").num(t->bytes.sum()).put(" bytes from ~").fixed(t->senders.estimate(), 0);
+    out.put(" senders (±").fixed(t->senders.error() * 100, 1).put("%), ").num(shards).put(" shards of ");
+    out.fixed(sizeof(TrafficSketch) / 1024.0, 1).put(" KiB\n");
+    out.put("top sources (bytes, overestimate <= ").num(t->top_sources.error_bound()).put("):\n");
+    for (auto *e : t->top_sources.top())
+        out.put("  ").pad(e->name(), 24).put(' ').num(e->count).put(" (+<=").num(e->error).put(")\n");
+    out.put("top topics (bytes, overestimate <= ").num(t->top_topics.error_bound()).put("):\n");
+    for (auto *e : t->top_topics.top())
+    {
+        out.put("  ").pad(e->name(), 24).put(' ').num(e->count).put(" (+<=").num(e->error).put(") ~");
+        out.fixed(e->extra.estimate(), 0).put(" senders (±").fixed(e->extra.error() * 100, 0).put("%)\n");
+    }
+}
+
+/**
+ * @brief 查询网卡的协商速率
+ * @param iface 网卡名，空表示第一个已启用的非环回 IPv4 网卡
+ * @return 速率（Mbit/s），无法获取（虚拟网卡、无权限等）时为 0
+ */
+double detect_link_mbps(std::string iface)
+{
+    if (iface.empty())
+    {
+        ifaddrs *list = nullptr;
+        if (getifaddrs(&list) != 0)
+            return 0;
+        for (auto *ifa = list; ifa; ifa = ifa->ifa_next)
+        {
+            if (ifa->ifa_addr && ifa->ifa_addr->sa_family == AF_INET && (ifa->ifa_flags & IFF_UP) && !(ifa->ifa_flags & IFF_LOOPBACK))
+            {
+                iface = ifa->ifa_name;
+                break;
+            }
+        }
+        freeifaddrs(list);
+    }
+    FILE *fp = iface.empty() ? nullptr : fopen(("/sys/class/net/" + iface + "/speed").c_str(), "r");
     if (!fp)
+        return 0;
+    long speed = 0;
+    if (fscanf(fp, "%ld", &speed) != 1)
+        speed = 0;
+    fclose(fp);
+    return speed > 0 ? static_cast<double>(speed) : 0;
+}
+
+/**
+ * @brief 输出发现协议的开销：全网总量及其占链路容量的比例，以及开销最大的节点
+ * @details 节点的开销包括其 RNDP 通告与其端点的 REDP 报文；字节数含以太网、IPv4 与 UDP 头，CPU 为检查器解析并更新
+ *          状态的耗时（不含锁等待）。速率为 60 s 时间常数的指数衰减平均
+ * @param state 全局状态对象
+ * @param n 参数个数（含命令名）
+ * @param args 命令参数，`discovery-cost [cpu] [N]`，默认按字节速率排序并输出前 10 个节点，`cpu` 改为按处理耗时排序
+ * @param link_mbps 链路容量（Mbit/s），0 表示未知
+ * @param out 输出缓冲区
+ */
+void print_discovery_cost(MonitorState &state, int n, char args[][64], double link_mbps, TextBuffer &out)
+{
+    bool by_cpu = n >= 2 && !strcmp(args[1], "cpu");
+    size_t top = n >= 2 + by_cpu ? static_cast<size_t>(std::max(atoi(args[1 + by_cpu]), 1)) : 10;
+    std::lock_guard<std::mutex> lock(state.mtx);
+    auto now = Clock::now();
+    auto &total = state.discovery;
+    double bps = total.bytes.per_second(now), pps = total.packets.per_second(now), cpu = total.cpu_ns.per_second(now);
+    out.put("discovery: ").fixed(pps, 1).put(" pkt/s, ").fixed(bps / 1024, 1).put(" KiB/s, cpu ");
+    out.fixed(cpu / 1e9 * 100, 3).put("% (total ").num(total.total_packets).put(" pkts, ").num(total.total_bytes).put(" bytes)\n");
+    if (link_mbps > 0)
+        out.put("link: ").fixed(bps * 8 / (link_mbps * 1e6) * 100, 4).put("% of ").fixed(link_mbps, 0).put(" Mbit/s\n");
+    else
+        out.put("link: capacity unknown, set --link-mbps=<N>\n");
+
+    struct Row
+    {
+        const NodeInfo *node;
+        double bps, pps, cpu;
+    };
+    std::vector<Row> rows;
+    rows.reserve(state.nodes.size());
+    double attributed = 0;
+    for (auto &[p, node] : state.nodes)
+    {
+        rows.push_back({&node, node.cost.bytes.per_second(now), node.cost.packets.per_second(now), node.cost.cpu_ns.per_second(now)});
+        attributed += rows.back().bps;
+    }
+    top = std::min(top, rows.size());
+    std::partial_sort(rows.begin(), rows.begin() + top, rows.end(),
+                      [by_cpu](const Row &a, const Row &b) { return by_cpu ? a.cpu > b.cpu : a.bps > b.bps; });
+    out.format("  %-24s %9s %10s %7s %10s\n", "node", "pkt/s", "B/s", "share", "cpu us/s");
+    for (size_t i = 0; i < top; i++)
+    {
+        auto &r = rows[i];
+        out.put("  ").pad(state.names.str(r.node->name_id), 24).format(" %9.2f %10.1f %6.1f%% %10.1f\n", r.pps, r.bps, bps > 0 ? r.bps / bps * 100 : 0.0, r.cpu / 1e3);
+    }
+    if (bps > attributed)
+        out.format("  %-24s %9s %10.1f %6.1f%%\n", "(no node)", "", bps - attributed, (bps - attributed) / bps * 100);
+}
+
+/**
+ * @brief 以迷你折线图输出一条时间序列的各分辨率历史
+ * @param out 输出缓冲区
+ * @param label 指标名称
+ * @param ts 时间序列
+ */
+void print_series(TextBuffer &out, const char *label, const TimeSeries &ts)
+{
+    static const char *BARS[] = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+    for (size_t level = 0; level < TimeSeries::LEVELS; level++)
+    {
+        auto v = ts.recent(level, 60);
+        if (v.empty())
+            continue;
+        auto [lo, hi] = std::minmax_element(v.begin(), v.end());
+        out.put("  ").pad(level == 0 ? label : "", 10).put(' ').put(TimeSeries::LABELS[level]).put(' ');
+        for (float x : v)
+            out.put(BARS[*hi > *lo ? static_cast<int>((x - *lo) / (*hi - *lo) * 7 + 0.5f) : 0]);
+        out.format("  min=%.4g max=%.4g last=%.4g\n", *lo, *hi, v.back());
+    }
+}
+
+/**
+ * @brief 输出节点或话题的指标历史
+ * @param state 全局状态对象
+ * @param name 节点名或话题名
+ * @param out 输出缓冲区
+ */
+void print_history(MonitorState &state, const char *name, TextBuffer &out)
+{
+    std::lock_guard<std::mutex> lock(state.mtx);
+    uint32_t id = state.names.lookup(name);
+    for (auto &[p, node] : state.nodes)
+    {
+        if (id != UINT32_MAX && node.name_id == id && node.history)
+        {
+            out.put("node ").put(name).put('\n');
+            print_series(out, "endpoints", node.history->endpoints);
+            print_series(out, "rate(Hz)", node.history->rate);
+            print_series(out, "jitter(ms)", node.history->jitter);
+            print_series(out, "loss(%)", node.history->loss);
+            return;
+        }
+    }
+    auto it = state.topic_history.find(id);
+    if (it == state.topic_history.end())
+    {
+        out.put("No history for '").put(name).put("'\n");
         return;
+    }
+    out.put("topic ").put(name).put('\n');
+    print_series(out, "pubs", it->second.pubs);
+    print_series(out, "subs", it->second.subs);
+}
+
+//! 快照文件的首行，用于识别文件格式
+constexpr char SNAPSHOT_MAGIC[] = "lpss-snapshot 1\n";
+//! 快照文件中名称的最大长度，超出时视为文件损坏
+constexpr size_t SNAPSHOT_MAX_NAME = 1 << 16;
 
-    fprintf(fp, "digraph G {\n");
-    fprintf(fp, "  rankdir=LR;\n");
-    fprintf(fp, "  node [fontname=\"sans-serif\", fontsize=10];\n\n");
+/**
+ * @brief 将快照保存为文本文件
+ * @details 首行为 `SNAPSHOT_MAGIC`，其后每行一个条目：`N <prefix> <len>:<name>` 或 `E <guid> <P|S> <len>:<topic>`，
+ *          名称按原样写出并以字节数前缀界定，可含空白等任意字符
+ * @return 是否保存成功
+ */
+bool save_snapshot(const MonitorState &state, const Snapshot &snap, const char *path)
+{
+    FILE *fp = fopen(path, "w");
+    if (!fp)
+        return false;
+    bool ok = fputs(SNAPSHOT_MAGIC, fp) != EOF;
+    auto put_name = [&](std::string_view s) {
+        ok = ok && fprintf(fp, "%zu:", s.size()) > 0 && fwrite(s.data(), 1, s.size(), fp) == s.size() && fputc('\n', fp) != EOF;
+    };
+    for (auto &n : snap.nodes)
+    {
+        ok = ok && fprintf(fp, "N %lx ", n.prefix) > 0;
+        put_name(state.names.str(n.name));
+    }
+    for (auto &e : snap.endpoints)
+    {
+        ok = ok && fprintf(fp, "E %lx %c ", e.guid, e.is_pub ? 'P' : 'S') > 0;
+        put_name(state.names.str(e.topic));
+    }
+    return fclose(fp) == 0 && ok;
+}
 
-    // topic (椭圆节点)
-    std::set<std::string> all_topics;
-    for (auto &pair : state.topics)
+/**
+ * @brief 从 `save_snapshot` 生成的文本文件读取快照
+ * @note 文件有任何不合法或残缺之处时读取失败，`snap` 保持不变
+ * @return 是否读取成功
+ */
+bool load_snapshot(MonitorState &state, Snapshot &snap, const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return false;
+    struct Entry
+    {
+        uint64_t id;
+        char kind; //!< `N`、`P` 或 `S`
+        std::string name;
+    };
+    std::vector<Entry> entries;
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    bool ok = fgets(magic, sizeof(magic), fp) && !strcmp(magic, SNAPSHOT_MAGIC);
+    for (int c; ok && (c = fgetc(fp)) != EOF;)
     {
-        for (auto &ep : pair.second)
+        Entry e{0, 'N', {}};
+        size_t len = 0;
+        if (c == 'N')
+            ok = fscanf(fp, " %lx %zu:", &e.id, &len) == 2;
+        else if (c == 'E')
+            ok = fscanf(fp, " %lx %c %zu:", &e.id, &e.kind, &len) == 3 && (e.kind == 'P' || e.kind == 'S');
+        else
+            ok = false;
+        if (!ok || len > SNAPSHOT_MAX_NAME)
         {
-            all_topics.insert(ep.topic);
+            ok = false;
+            break;
         }
+        e.name.resize(len);
+        ok = fread(e.name.data(), 1, len, fp) == len && fgetc(fp) == '\n';
+        entries.push_back(std::move(e));
+    }
+    ok = ok && !ferror(fp);
+    fclose(fp);
+    if (!ok)
+        return false;
+
+    // 全部条目解析成功后才驻留名称，损坏的文件不会在驻留表中留下垃圾
+    Snapshot res;
+    for (auto &e : entries)
+    {
+        uint32_t name = state.names.intern(e.name);
+        if (e.kind == 'N')
+            res.nodes.push_back({e.id, name});
+        else
+            res.endpoints.push_back({e.id, name, e.kind == 'P'});
     }
+    std::sort(res.nodes.begin(), res.nodes.end(), [](auto &a, auto &b) { return a.prefix < b.prefix; });
+    std::sort(res.endpoints.begin(), res.endpoints.end(), [](auto &a, auto &b) { return a.guid < b.guid; });
+    snap = std::move(res);
+    return true;
+}
+
+/**
+ * @brief 比较两个快照并输出新增、移除与改名的节点及新增、移除的端点
+ * @param state 全局状态对象，调用方需持有 `state.mtx`
+ * @param a 旧快照
+ * @param b 新快照
+ * @param json 是否以 JSON 格式输出
+ * @param out 输出缓冲区
+ */
+void diff_snapshots(const MonitorState &state, const Snapshot &a, const Snapshot &b, bool json, TextBuffer &out)
+{
+    auto &pool = state.names;
+    auto name_of = [&](uint32_t id) { return id == UINT32_MAX ? std::string_view("?") : pool.str(id); };
 
-    for (const auto &t : all_topics)
+    // 两个有序数组线性归并，O(n + m)
+    std::vector<const Snapshot::Node *> added_nodes, removed_nodes;
+    std::vector<std::pair<const Snapshot::Node *, const Snapshot::Node *>> renamed;
+    for (size_t i = 0, j = 0; i < a.nodes.size() || j < b.nodes.size();)
     {
-        fprintf(fp, "  \"t_%s\" [label=\"%s\", shape=ellipse, style=filled, fillcolor=lightyellow];\n",
-                t.c_str(), t.c_str());
+        if (j == b.nodes.size() || (i < a.nodes.size() && a.nodes[i].prefix < b.nodes[j].prefix))
+            removed_nodes.push_back(&a.nodes[i++]);
+        else if (i == a.nodes.size() || b.nodes[j].prefix < a.nodes[i].prefix)
+            added_nodes.push_back(&b.nodes[j++]);
+        else
+        {
+            if (a.nodes[i].name != b.nodes[j].name)
+                renamed.emplace_back(&a.nodes[i], &b.nodes[j]);
+            i++, j++;
+        }
+    }
+    std::vector<std::pair<const Snapshot *, const Snapshot::Endpoint *>> added_eps, removed_eps;
+    for (size_t i = 0, j = 0; i < a.endpoints.size() || j < b.endpoints.size();)
+    {
+        if (j == b.endpoints.size() || (i < a.endpoints.size() && a.endpoints[i].guid < b.endpoints[j].guid))
+            removed_eps.emplace_back(&a, &a.endpoints[i++]);
+        else if (i == a.endpoints.size() || b.endpoints[j].guid < a.endpoints[i].guid)
+            added_eps.emplace_back(&b, &b.endpoints[j++]);
+        else
+        {
+            auto &ea = a.endpoints[i++], &eb = b.endpoints[j++];
+            if (ea.topic != eb.topic || ea.is_pub != eb.is_pub)
+                removed_eps.emplace_back(&a, &ea), added_eps.emplace_back(&b, &eb);
+        }
     }
 
-    // 2. 绘制节点及连线
-    for (auto &[prefix, name] : state.nodes)
+    if (!json)
     {
-        // Node ：蓝色方框
-        fprintf(fp, "  n%lx [label=\"%s\", shape=box, style=filled, fillcolor=lightblue];\n",
-                prefix, name.c_str());
+        for (auto *n : added_nodes)
+            out.put("+ node ").put(name_of(n->name)).put(" (").hex(n->prefix).put(")\n");
+        for (auto *n : removed_nodes)
+            out.put("- node ").put(name_of(n->name)).put(" (").hex(n->prefix).put(")\n");
+        for (auto &[from, to] : renamed)
+            out.put("~ node ").put(name_of(from->name)).put(" -> ").put(name_of(to->name)).put(" (").hex(to->prefix).put(")\n");
+        for (auto &[snap, e] : added_eps)
+            out.put(e->is_pub ? "+ [PUB] " : "+ [SUB] ").put(name_of(e->topic)).put(" @ ")
+                .put(name_of(snap->node_name(e->guid & 0xFFFFFFFFFFFFULL))).put('\n');
+        for (auto &[snap, e] : removed_eps)
+            out.put(e->is_pub ? "- [PUB] " : "- [SUB] ").put(name_of(e->topic)).put(" @ ")
+                .put(name_of(snap->node_name(e->guid & 0xFFFFFFFFFFFFULL))).put('\n');
+        out.format("nodes: +%zu -%zu ~%zu, endpoints: +%zu -%zu\n", added_nodes.size(), removed_nodes.size(),
+                   renamed.size(), added_eps.size(), removed_eps.size());
+        return;
+    }
 
-        // 建立连接
-        if (state.topics.count(prefix))
+    auto json_string = [&](std::string_view s) { out.put(json_quote(s)); };
+    auto print_nodes = [&](const char *key, const std::vector<const Snapshot::Node *> &list) {
+        out.put('"').put(key).put("\":[");
+        for (size_t i = 0; i < list.size(); i++)
         {
-            for (auto &ep : state.topics[prefix])
-            {
-                if (ep.is_pub)
-                {
-                    // 发布者：节点 -> 话题 (蓝色箭头)
-                    fprintf(fp, "  n%lx -> \"t_%s\" [color=blue, label=\"pub\"];\n", prefix, ep.topic.c_str());
-                }
-                else
-                {
-                    // 订阅者：话题 -> 节点 (绿色箭头)
-                    fprintf(fp, "  \"t_%s\" -> n%lx [color=darkgreen, label=\"sub\"];\n", ep.topic.c_str(), prefix);
-                }
-            }
+            out.put(i ? ",{\"guid\":\"" : "{\"guid\":\"").hex(list[i]->prefix).put("\",\"name\":");
+            json_string(name_of(list[i]->name));
+            out.put('}');
+        }
+        out.put(']');
+    };
+    auto print_eps = [&](const char *key, const std::vector<std::pair<const Snapshot *, const Snapshot::Endpoint *>> &list) {
+        out.put('"').put(key).put("\":[");
+        for (size_t i = 0; i < list.size(); i++)
+        {
+            auto &[snap, e] = list[i];
+            out.put(i ? ",{\"guid\":\"" : "{\"guid\":\"").hex(e->guid);
+            out.put(e->is_pub ? "\",\"kind\":\"pub\",\"topic\":" : "\",\"kind\":\"sub\",\"topic\":");
+            json_string(name_of(e->topic));
+            out.put(",\"node\":");
+            json_string(name_of(snap->node_name(e->guid & 0xFFFFFFFFFFFFULL)));
+            out.put('}');
         }
+        out.put(']');
+    };
+    out.put("{\"nodes\":{");
+    print_nodes("added", added_nodes);
+    out.put(',');
+    print_nodes("removed", removed_nodes);
+    out.put(",\"renamed\":[");
+    for (size_t i = 0; i < renamed.size(); i++)
+    {
+        out.put(i ? ",{\"guid\":\"" : "{\"guid\":\"").hex(renamed[i].second->prefix).put("\",\"from\":");
+        json_string(name_of(renamed[i].first->name));
+        out.put(",\"to\":");
+        json_string(name_of(renamed[i].second->name));
+        out.put('}');
     }
+    out.put("]},\"endpoints\":{");
+    print_eps("added", added_eps);
+    out.put(',');
+    print_eps("removed", removed_eps);
+    out.put("}}\n");
+}
 
-    fprintf(fp, "}\n");
-    fclose(fp);
+/**
+ * @brief 查找具名快照，不存在时尝试将名称作为快照文件路径读取
+ * @note 从文件读取的快照只存放于 `scratch`，不加入具名快照，每次比较都重新读取文件
+ * @param[out] scratch 从文件读取的快照的存放位置
+ * @return 快照指针，均失败时返回 `nullptr`
+ */
+const Snapshot *resolve_snapshot(MonitorState &state, const char *name, Snapshot &scratch)
+{
+    auto it = state.marks.find(name);
+    if (it != state.marks.end())
+        return &it->second;
+    return load_snapshot(state, scratch, name) ? &scratch : nullptr;
+}
 
-    system("dot -Tpng lpss_graph.dot -o lpss_graph.png && xdg-open lpss_graph.png > /dev/null 2>&1 &");///打开图片
+/**
+ * @brief 处理 `mark`、`save`、`load` 与 `diff` 命令
+ * @param state 全局状态对象
+ * @param argc 参数个数（含命令本身）
+ * @param argv 命令与参数
+ * @param out 输出缓冲区
+ */
+void snapshot_command(MonitorState &state, int argc, char (*argv)[64], TextBuffer &out)
+{
+    std::lock_guard<std::mutex> lock(state.mtx);
+    const char *cmd = argv[0];
+    if (!strcmp(cmd, "mark") && argc == 2)
+        state.marks[argv[1]] = take_snapshot(state);
+    else if (!strcmp(cmd, "save") && argc == 3)
+    {
+        auto it = state.marks.find(argv[1]);
+        if (it == state.marks.end() || !save_snapshot(state, it->second, argv[2]))
+            out.format("Cannot save '%s' to '%s'\n", argv[1], argv[2]);
+    }
+    else if (!strcmp(cmd, "load") && argc == 3)
+    {
+        Snapshot snap;
+        if (load_snapshot(state, snap, argv[2]))
+            state.marks[argv[1]] = std::move(snap);
+        else
+            out.format("Cannot load '%s'\n", argv[2]);
+    }
+    else if (!strcmp(cmd, "diff") && argc >= 3)
+    {
+        bool json = argc == 4 && !strcmp(argv[3], "json");
+        Snapshot live, file_a, file_b;
+        const Snapshot *a, *b;
+        if (!strcmp(argv[1], "since"))
+        {
+            a = resolve_snapshot(state, argv[2], file_a);
+            live = take_snapshot(state);
+            b = &live;
+        }
+        else
+        {
+            a = resolve_snapshot(state, argv[1], file_a);
+            b = resolve_snapshot(state, argv[2], file_b);
+        }
+        if (!a || !b)
+            out.put("Unknown snapshot\n");
+        else
+            diff_snapshots(state, *a, *b, json, out);
+    }
+    else
+        out.put("Usage: mark <name> | save <name> <file> | load <name> <file> | diff <a> <b> [json] | diff since <mark> [json]\n");
 }
 
-int main()
+/**
+ * @brief 按节点名查找节点
+ * @param state 全局状态对象，调用方需持有 `state.mtx`
+ * @param name 节点名
+ * @return 节点 GUID 前缀，未找到时返回 `UINT64_MAX`
+ */
+uint64_t find_node(const MonitorState &state, const char *name)
 {
-    MonitorState state;         
-    auto my_ip = get_local_ip();
-    Guid my_guid;
-    my_guid.full = 0x12345678; 
+    uint32_t id = state.names.lookup(name);
+    if (id == UINT32_MAX)
+        return UINT64_MAX;
+    for (auto &[prefix, node] : state.nodes)
+        if (node.name_id == id)
+            return prefix;
+    return UINT64_MAX;
+}
 
-    auto unicast_sock = rm::Listener(rm::Endpoint(rm::ip::udp::v4(), rm::Endpoint::ANY_PORT)).create(); /// 创建 REDP 监听 Socket
-    uint16_t my_port = unicast_sock.endpoint().port();                                                  /// 获取分配的端口号
+/**
+ * @brief 处理 `path` 与 `downstream` 数据流可达性查询
+ * @param state 全局状态对象
+ * @param argc 参数个数（含命令本身）
+ * @param argv 命令与参数
+ * @param out 输出缓冲区
+ */
+void reach_command(MonitorState &state, int argc, char (*argv)[64], TextBuffer &out)
+{
+    std::lock_guard<std::mutex> lock(state.mtx);
+    auto name_of = [&](uint64_t prefix) {
+        auto it = state.nodes.find(prefix);
+        return it != state.nodes.end() ? state.names.str(it->second.name_id) : std::string_view("?");
+    };
+    uint64_t from = find_node(state, argv[1]);
+    if (from == UINT64_MAX)
+    {
+        out.format("Unknown node '%s'\n", argv[1]);
+        return;
+    }
+    if (!strcmp(argv[0], "downstream"))
+    {
+        auto nodes = state.reach.downstream(from);
+        for (uint64_t p : nodes)
+            out.put("- ").put(name_of(p)).put('\n');
+        out.num(nodes.size()).put(" downstream nodes\n");
+        return;
+    }
+    uint64_t to = argc == 3 ? find_node(state, argv[2]) : UINT64_MAX;
+    if (to == UINT64_MAX)
+    {
+        out.format("Unknown node '%s'\n", argc == 3 ? argv[2] : "");
+        return;
+    }
+    auto hops = state.reach.path(from, to);
+    if (hops.empty())
+    {
+        out.format("No data path from %s to %s\n", argv[1], argv[2]);
+        return;
+    }
+    out.put(name_of(hops[0].second));
+    for (size_t i = 1; i < hops.size(); i++)
+        out.put(" -> [").put(state.names.str(hops[i].first)).put("] -> ").put(name_of(hops[i].second));
+    out.put('\n');
+}
 
-    
-    auto fut_a = std::async(std::launch::async, task_nodes, &state);/// 启动节点监听任务                         
-    auto fut_b = std::async(std::launch::async, task_topics, &state, std::move(unicast_sock));/// 启动话题监听任务    
-    auto fut_c = std::async(std::launch::async, task_heartbeat, &state, my_guid, my_port, my_ip);/// 启动心跳广播任务 
-    printf("LPSS Async Monitor running. Commands: list, info <name>, graph, quit\n");
+/**
+ * @brief 输出监控器自身的运行统计
+ * @param state 全局状态对象
+ * @param out 输出缓冲区
+ */
+void print_stats(MonitorState &state, TextBuffer &out)
+{
+    std::lock_guard<std::mutex> lock(state.mtx);
+    size_t endpoints = 0;
+    for (auto &[p, eps] : state.topics)
+        endpoints += eps.size();
+    out.format("memory: %.1f KiB in %zu entries (%zu nodes, %zu endpoints) + %.1f KiB reach index", state.lru.bytes() / 1024.0,
+               state.lru.size(), state.nodes.size(), endpoints, state.reach.bytes() / 1024.0);
+    if (state.mem_cap)
+        out.format(", cap %.1f KiB\n", state.mem_cap / 1024.0);
+    else
+        out.put(", no cap\n");
+    out.format("evicted: %lu nodes, %lu endpoints (%.1f KiB)\n", state.evicted_nodes, state.evicted_endpoints,
+               state.evicted_bytes / 1024.0);
+    out.format("flap records: %zu nodes, %zu endpoints\n", state.node_flaps.records.size(), state.endpoint_flaps.records.size());
+    out.format("topic history: %zu topics, %.1f KiB", state.topic_history.size(),
+               state.topic_history.size() * MonitorState::TOPIC_HISTORY_BYTES / 1024.0);
+    if (state.max_topic_history)
+        out.format(", limit %zu\n", state.max_topic_history);
+    else
+        out.put(", no limit\n");
+    out.format("reach cache: %.1f KiB\n", state.reach.cache_bytes() / 1024.0);
+    out.format("string pool: %zu strings, %.1f KiB\n", state.names.size(), state.names.bytes() / 1024.0);
+}
+
+/**
+ * @brief 输出监控器自身的 CPU 占用与降级等级
+ * @param state 全局状态对象
+ * @param out 输出缓冲区
+ */
+void print_cpu(MonitorState &state, TextBuffer &out)
+{
+    auto &gov = state.governor;
+    out.put("cpu: ").fixed(gov.usage() * 100, 1).put('%');
+    if (gov.budget > 0)
+        out.put(" (budget ").fixed(gov.budget * 100, 1).put("%)");
+    else
+        out.put(" (no budget)");
+    auto level = gov.level();
+    out.put(", level ").num(level).put(" (").put(CpuGovernor::LEVEL_DESC[level]).put("), transitions ").num(gov.transitions());
+    auto usage = gov.class_usage();
+    for (size_t i = 0; i < usage.size(); i++)
+        out.put(i ? ", " : "\n  ").put(ThreadPlacement::CLASS_NAMES[i]).put(' ').fixed(usage[i] * 100, 1).put('%');
+    out.put('\n');
+}
+
+/**
+ * @brief 输出各线程实际生效的 CPU 亲和性、调度策略与 nice 值
+ * @param out 输出缓冲区
+ */
+void print_threads(TextBuffer &out)
+{
+    out.put("threads:\n");
+    for (auto &t : ThreadPlacement::global().snapshot())
+    {
+        out.put("  ").pad(t.name, 16).put(' ').pad(ThreadPlacement::CLASS_NAMES[t.cls], 10);
+        out.put(" tid=").num(t.tid).put(" cpus=").put(ThreadPlacement::cpu_list(t.cpus));
+        out.put(" (on ").put(t.current_cpu < 0 ? std::string("?") : std::to_string(t.current_cpu)).put(')');
+        out.put(" policy=").put(ThreadPlacement::policy_name(t.policy));
+        if (t.policy == SCHED_FIFO || t.policy == SCHED_RR)
+            out.put(" prio=").num(t.priority);
+        out.format(" nice=%d", t.nice);
+        if (!t.error.empty())
+            out.put(" [").put(t.error).put(']');
+        out.put('\n');
+    }
+}
+
+/**
+ * @brief 输出指标注册表中全部指标的聚合值
+ * @param out 输出缓冲区
+ */
+void print_metrics(TextBuffer &out)
+{
+    out.put("metrics:\n");
+    for (auto &m : metrics().collect())
+    {
+        out.put("  ").pad(m.name, 24).put(' ');
+        if (m.kind == MetricsRegistry::Kind::Histogram)
+            out.put("n=").num(m.value).put(" p50<=").num(m.quantile(0.5)).put(" p99<=").num(m.quantile(0.99))
+                .put(" max<=").num(m.quantile(1.0)).put('\n');
+        else if (m.value < 0)
+            out.put('-').num(-m.value).put('\n');
+        else
+            out.num(m.value).put('\n');
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // 线程放置须在任何线程启动前配置
+    for (int i = 1; i < argc; i++)
+    {
+        std::string err;
+        if (!strncmp(argv[i], "--thread=", 9) && !ThreadPlacement::global().configure(argv[i] + 9, err))
+        {
+            printf("Invalid thread placement '%s': %s\n", argv[i] + 9, err.c_str());
+            return 1;
+        }
+    }
+
+    InspectorOptions opts;
+    AlertDispatcher alerts;
+    RuleEngine rules(alerts);
+    std::vector<const char *> rule_files;
+    int web_port = -1;
+    double link_mbps = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strncmp(argv[i], "--thread=", 9))
+            continue;
+        else if (!strncmp(argv[i], "--endpoint-ttl=", 15))
+            opts.endpoint_ttl = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(atof(argv[i] + 15)));
+        else if (!strncmp(argv[i], "--mem-cap=", 10))
+            opts.mem_cap = static_cast<size_t>(atof(argv[i] + 10) * 1024 * 1024);
+        else if (!strncmp(argv[i], "--cpu-budget=", 13))
+            opts.cpu_budget = atof(argv[i] + 13) / 100;
+        else if (!strcmp(argv[i], "--passive") || !strncmp(argv[i], "--passive=", 10))
+        {
+            opts.passive = true;
+            opts.capture_if = argv[i][9] ? argv[i] + 10 : "";
+        }
+        else if (!strncmp(argv[i], "--web=", 6))
+            web_port = atoi(argv[i] + 6);
+        else if (!strncmp(argv[i], "--link-mbps=", 12))
+            link_mbps = atof(argv[i] + 12);
+        else if (!strncmp(argv[i], "--rules=", 8))
+            rule_files.push_back(argv[i] + 8);
+        else if (!strncmp(argv[i], "--alert=", 8))
+        {
+            if (!alerts.add_sink(argv[i] + 8))
+            {
+                printf("Invalid alert sink '%s'\n", argv[i] + 8);
+                return 1;
+            }
+        }
+        else
+        {
+            printf("Usage: %s [--endpoint-ttl=<seconds>] [--mem-cap=<MiB>] [--cpu-budget=<percent>] [--passive[=<interface>]] [--web=<port>] [--link-mbps=<N>] "
+                   "[--rules=<file>]... "
+                   "[--alert=stdout|file:<path>|exec:<command>]... "
+                   "[--thread=<receive|heartbeat|exporter|render|all>:cpus=<list>,policy=<name>,prio=<N>,nice=<N>]...\n",
+                   argv[0]);
+            return 1;
+        }
+    }
+    if (link_mbps <= 0)
+        link_mbps = detect_link_mbps(opts.capture_if);
+    Inspector inspector(opts);
+    MonitorState &state = inspector.state();
+    for (auto path : rule_files)
+    {
+        FILE *fp = fopen(path, "r");
+        if (!fp)
+        {
+            printf("Cannot open rules file '%s'\n", path);
+            return 1;
+        }
+        char line[256];
+        while (fgets(line, sizeof(line), fp))
+        {
+            line[strcspn(line, "\r\n")] = '\0';
+            if (line[0] && line[0] != '#' && !rules.add(line, state))
+                printf("Invalid rule: %s\n", line);
+        }
+        fclose(fp);
+    }
+    inspector.subscribe([&rules](const TopologyEvent &e) { rules.on_event(e); });
+    std::string err;
+    if (!inspector.start(&err))
+    {
+        printf("%s\n", err.c_str());
+        return 1;
+    }
+    if (!inspector.kernel_timestamps())
+        printf("Warning: kernel receive timestamps unavailable\n");
+    if (opts.passive)
+        printf("Passive mode: capturing on %s, nothing will be sent\n", opts.capture_if.empty() ? "all interfaces" : opts.capture_if.c_str());
+    WebUi web(inspector);
+    if (web_port >= 0)
+    {
+        if (!web.start(static_cast<uint16_t>(web_port), &err))
+        {
+            printf("%s\n", err.c_str());
+            return 1;
+        }
+        printf("Web UI at http://127.0.0.1:%d/\n", web_port);
+    }
+    // 命令行线程最后应用放置，避免各任务线程在创建时继承 render 类别的设置
+    auto placed = ThreadPlacement::global().enter(ThreadPlacement::Render, "lpss-cli");
+    printf("LPSS Async Monitor running. Commands: list [filter], watch [filter], info <name>, find <text|glob>, history <node|topic>, mark/save/load/diff, path <a> <b>, downstream <node>, rule <rule>, rules, stats, churn, traffic [ip:port [topic]], discovery-cost [cpu] [N], graph [filter], quit\n");
 
     /**
      * @brief 命令行交互界面
      */
-    char buf[256], cmd[64], arg[64];
+    char buf[256], args[4][64];
+    char *cmd = args[0], *arg = args[1];
+    TextBuffer out; // 各命令持锁时写入，释放锁后统一输出
+    GraphLayout layout;
+    layout.load("lpss_graph.layout");
+    auto commands = metrics().counter("cli.commands");
+    auto output_bytes = metrics().counter("cli.output_bytes");
     while (true)
     {
         printf("> ");
         if (!fgets(buf, sizeof(buf), stdin))
             break;
-        int n = sscanf(buf, "%s %s", cmd, arg);
+        int n = sscanf(buf, "%63s %63s %63s %63s", args[0], args[1], args[2], args[3]);
         if (n <= 0)
             continue;
 
-        if (!strcmp(cmd, "list"))
+        if (!strcmp(cmd, "list") || !strcmp(cmd, "watch") || !strcmp(cmd, "graph"))
         {
-            std::lock_guard<std::mutex> lock(state.mtx);
-            for (auto &[p, name] : state.nodes)
-                printf("- %s\n", name.c_str());
+            NodeFilter filter;
+            std::string err;
+            if (!filter.compile(command_tail(buf), err))
+                out.put("Invalid filter: ").put(err).put('\n');
+            else if (!strcmp(cmd, "list"))
+                print_nodes(state, filter, out);
+            else if (!strcmp(cmd, "watch"))
+                watch_nodes(state, filter, out);
+            else if (state.governor.level() >= CpuGovernor::Minimal)
+                out.put("Graph rendering is disabled while over the CPU budget (see stats)\n");
+            else
+                generate_graph(state, filter, layout, out);
         }
         else if (!strcmp(cmd, "info") && n == 2)
         {
             std::lock_guard<std::mutex> lock(state.mtx);
-            for (auto &[p, name] : state.nodes)
+            uint32_t id = state.names.lookup(arg);
+            for (auto &[p, node] : state.nodes)
             {
-                if (name == arg)
+                if (id != UINT32_MAX && node.name_id == id)
                 {
-                    for (auto &ep : state.topics[p])
-                        printf("  [%s] %s\n", ep.is_pub ? "PUB" : "SUB", ep.topic.c_str());
+                    auto eps = state.topics.find(p);
+                    if (eps == state.topics.end())
+                        continue;
+                    for (auto &[guid, ep] : eps->second)
+                        out.put(ep.is_pub ? "  [PUB] " : "  [SUB] ").put(state.names.str(ep.topic_id)).put(ep.held ? " (held)\n" : "\n");
                 }
             }
         }
-        else if (!strcmp(cmd, "graph"))
-            generate_graph(state);
+        else if (!strcmp(cmd, "stats"))
+        {
+            print_stats(state, out);
+            print_cpu(state, out);
+            print_threads(out);
+            print_metrics(out);
+        }
+        else if (!strcmp(cmd, "find") && n == 2)
+            find_names(state, arg, out);
+        else if (!strcmp(cmd, "history") && n == 2)
+            print_history(state, arg, out);
+        else if (!strcmp(cmd, "mark") || !strcmp(cmd, "save") || !strcmp(cmd, "load") || !strcmp(cmd, "diff"))
+            snapshot_command(state, n, args, out);
+        else if ((!strcmp(cmd, "path") && n == 3) || (!strcmp(cmd, "downstream") && n == 2))
+            reach_command(state, n, args, out);
+        else if (!strcmp(cmd, "rule") && n >= 2)
+        {
+            std::lock_guard<std::mutex> lock(state.mtx);
+            if (!rules.add(command_tail(buf), state))
+                out.put("Invalid rule. Syntax: topic <name|*> <pubs|subs> <op> <N> | node <name> alive\n");
+        }
+        else if (!strcmp(cmd, "rules"))
+        {
+            std::lock_guard<std::mutex> lock(state.mtx);
+            rules.print(out);
+        }
+        else if (!strcmp(cmd, "churn"))
+            print_churn(state, out);
+        else if (!strcmp(cmd, "traffic"))
+            print_traffic(state, n, args, out);
+        else if (!strcmp(cmd, "discovery-cost"))
+            print_discovery_cost(state, n, args, link_mbps, out);
         else if (!strcmp(cmd, "quit"))
             break;
+        commands.add();
+        output_bytes.add(out.view().size());
+        out.flush();
     }
 
-    state.running = false;
-    printf("Shutting down... (Waiting for final packets to unblock threads)\n");
+    printf("Shutting down...\n");
+    inspector.stop();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,211 @@
+/**
+ * @file metrics.hpp
+ * @author Nq139 (fnq409997@gmail.com)
+ * @brief 按线程分片、缓存行对齐的指标注册表
+ * @copyright Copyright 2026, Nq139
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//! 缓存行大小
+constexpr size_t CACHE_LINE = 64;
+
+/**
+ * @brief 指标注册表
+ * @details 每个线程首次写入指标时获得一块独占的、按缓存行对齐的槽位数组，计数器、仪表与直方图均只写本线程的槽位，
+ *          写入为一次无竞争的读-改-写，不同线程之间不共享缓存行。只有 `collect()` 读取时才对全部线程的槽位求和。
+ *          线程退出时其槽位累加到退役区后回收，供之后创建的线程复用，短生命周期线程不会使槽位数组无限增长
+ */
+class MetricsRegistry
+{
+public:
+    //! 槽位总数上限，直方图占 `HIST_BUCKETS` 个槽位，其余指标各占 1 个
+    static constexpr size_t MAX_SLOTS = 512;
+    //! 直方图桶数，第 `i` 个桶（`i > 0`）统计 `[2^(i-1), 2^i)` 内的样本，末桶包含更大的值
+    static constexpr size_t HIST_BUCKETS = 32;
+
+    enum class Kind : uint8_t
+    {
+        Counter,   //!< 单调递增计数
+        Gauge,     //!< 可增可减的量，各线程的增量之和即为当前值
+        Histogram, //!< 按 2 的幂分桶的分布
+    };
+
+    //! 计数器句柄
+    struct Counter
+    {
+        uint32_t slot;
+        void add(uint64_t n = 1) const { MetricsRegistry::bump(slot, n); }
+    };
+
+    //! 仪表句柄，以增量方式更新，因而可由多个线程同时维护同一个量
+    struct Gauge
+    {
+        uint32_t slot;
+        void add(int64_t n) const { MetricsRegistry::bump(slot, static_cast<uint64_t>(n)); }
+        void sub(int64_t n) const { add(-n); }
+    };
+
+    //! 直方图句柄
+    struct Histogram
+    {
+        uint32_t slot;
+        void record(uint64_t v) const
+        {
+            size_t bucket = v ? std::min<size_t>(64 - __builtin_clzll(v), HIST_BUCKETS - 1) : 0;
+            MetricsRegistry::bump(slot + static_cast<uint32_t>(bucket), 1);
+        }
+    };
+
+    //! 一个指标的聚合结果
+    struct Sample
+    {
+        std::string name;
+        Kind kind;
+        int64_t value;                //!< 计数器与仪表的值，直方图的样本数
+        std::vector<uint64_t> bucket; //!< 直方图各桶计数
+
+        //! 分位数 `q` 所在桶的上界，样本为空时返回 0
+        uint64_t quantile(double q) const
+        {
+            if (value <= 0)
+                return 0;
+            uint64_t rank = std::min<uint64_t>(static_cast<uint64_t>(q * value), value - 1), seen = 0;
+            for (size_t i = 0; i < bucket.size(); i++)
+                if ((seen += bucket[i]) > rank)
+                    return i ? (1ULL << i) - 1 : 0;
+            return 0;
+        }
+    };
+
+    //! 全局注册表
+    static MetricsRegistry &global()
+    {
+        static MetricsRegistry registry;
+        return registry;
+    }
+
+    //! 注册或取得已注册的计数器
+    Counter counter(const std::string &name) { return {add(name, Kind::Counter, 1)}; }
+    //! 注册或取得已注册的仪表
+    Gauge gauge(const std::string &name) { return {add(name, Kind::Gauge, 1)}; }
+    //! 注册或取得已注册的直方图
+    Histogram histogram(const std::string &name) { return {add(name, Kind::Histogram, HIST_BUCKETS)}; }
+
+    //! 对全部线程的槽位求和，按注册顺序返回各指标
+    std::vector<Sample> collect()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        uint64_t total[MAX_SLOTS];
+        for (size_t i = 0; i < used; i++)
+            total[i] = retired.v[i].load(std::memory_order_relaxed);
+        for (auto &slab : slabs)
+            if (slab->owned)
+                for (size_t i = 0; i < used; i++)
+                    total[i] += slab->v[i].load(std::memory_order_relaxed);
+        std::vector<Sample> res;
+        for (auto &m : metrics)
+        {
+            Sample s{m.name, m.kind, 0, {}};
+            if (m.kind == Kind::Histogram)
+            {
+                s.bucket.assign(total + m.slot, total + m.slot + HIST_BUCKETS);
+                for (uint64_t c : s.bucket)
+                    s.value += c;
+            }
+            else
+                s.value = static_cast<int64_t>(total[m.slot]);
+            res.push_back(std::move(s));
+        }
+        return res;
+    }
+
+private:
+    //! 单个线程的槽位，按缓存行对齐以免与其他线程的槽位共享缓存行
+    struct alignas(CACHE_LINE) Slab
+    {
+        std::atomic<uint64_t> v[MAX_SLOTS]{};
+        bool owned{};
+    };
+
+    //! 线程退出时归还槽位
+    struct SlabRef
+    {
+        Slab *slab{};
+        ~SlabRef()
+        {
+            if (slab)
+                global().retire(slab);
+        }
+    };
+
+    struct Metric
+    {
+        std::string name;
+        Kind kind;
+        uint32_t slot;
+    };
+
+    //! 当前线程的槽位增加 `n`，仅本线程写入，因此无需原子读-改-写
+    static void bump(uint32_t slot, uint64_t n)
+    {
+        thread_local SlabRef ref;
+        if (!ref.slab)
+            ref.slab = global().acquire();
+        auto &v = ref.slab->v[slot];
+        v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    uint32_t add(const std::string &name, Kind kind, size_t width)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto &m : metrics)
+            if (m.name == name)
+                return m.slot;
+        if (used + width > MAX_SLOTS - HIST_BUCKETS)
+            return MAX_SLOTS - HIST_BUCKETS; // 超出上限的指标共用末尾的保留槽位，不参与输出
+        metrics.push_back({name, kind, static_cast<uint32_t>(used)});
+        used += width;
+        return metrics.back().slot;
+    }
+
+    Slab *acquire()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto &slab : slabs)
+            if (!slab->owned)
+                return slab->owned = true, slab.get();
+        slabs.push_back(std::make_unique<Slab>());
+        slabs.back()->owned = true;
+        return slabs.back().get();
+    }
+
+    void retire(Slab *slab)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (size_t i = 0; i < MAX_SLOTS; i++)
+        {
+            retired.v[i].store(retired.v[i].load(std::memory_order_relaxed) + slab->v[i].load(std::memory_order_relaxed),
+                               std::memory_order_relaxed);
+            slab->v[i].store(0, std::memory_order_relaxed);
+        }
+        slab->owned = false;
+    }
+
+    std::mutex mtx;
+    std::vector<Metric> metrics;
+    size_t used{};
+    std::vector<std::unique_ptr<Slab>> slabs;
+    Slab retired; //!< 已退出线程的累计值
+};
+
+//! 全局指标注册表
+inline MetricsRegistry &metrics() { return MetricsRegistry::global(); }
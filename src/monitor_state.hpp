@@ -0,0 +1,1076 @@
+/**
+ * @file monitor_state.hpp
+ * @author Nq139 (fnq409997@gmail.com)
+ * @brief LPSS 拓扑发现引擎的状态数据结构
+ * @copyright Copyright 2026, Nq139
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <rmvl/lpss.hpp>
+
+#include "cpu_governor.hpp"
+#include "string_pool.hpp"
+#include "traffic_sketch.hpp"
+#include "virtual_clock.hpp"
+
+//! 节点超时时间，超过该时间未收到 RNDP 通告的节点将被移除
+constexpr auto NODE_TTL = std::chrono::seconds(5);
+
+class LruList;
+
+/**
+ * @brief 侵入式 LRU 链表挂钩，嵌入节点与端点条目中
+ * @note 条目析构时自动脱链；复制得到的条目不继承链表位置
+ */
+struct LruHook
+{
+    LruHook *prev{};
+    LruHook *next{};
+    LruList *owner{};          //!< 所在链表，未链入时为空
+    size_t bytes{};            //!< 条目计入内存预算的字节数
+    uint64_t key{};            //!< 节点为 GUID 前缀，端点为完整端点 GUID
+    bool is_endpoint{};        //!< 条目类型
+    Clock::time_point stamp{}; //!< 链表排序所依据的最近出现时间
+
+    LruHook() = default;
+    LruHook(const LruHook &) : LruHook() {}
+    LruHook &operator=(const LruHook &) { return *this; }
+    inline ~LruHook();
+};
+
+/**
+ * @brief 按最近出现时间排序的侵入式 LRU 链表，同时统计链入条目的总字节数
+ * @note 所有操作均为 O(1)
+ */
+class LruList
+{
+public:
+    LruList() { head.prev = head.next = &head; }
+    LruList(const LruList &) = delete;
+    LruList &operator=(const LruList &) = delete;
+
+    /**
+     * @brief 将条目移至链表尾部（最近出现），未链入时链入
+     * @param[in] h 条目挂钩
+     * @param[in] key 条目标识
+     * @param[in] is_endpoint 条目类型
+     * @param[in] stamp 最近出现时间
+     * @param[in] bytes 条目当前占用的字节数
+     */
+    void touch(LruHook &h, uint64_t key, bool is_endpoint, Clock::time_point stamp, size_t bytes)
+    {
+        unlink(h);
+        h.prev = head.prev, h.next = &head;
+        head.prev->next = &h, head.prev = &h;
+        h.owner = this, h.key = key, h.is_endpoint = is_endpoint, h.stamp = stamp, h.bytes = bytes;
+        total += bytes, count++;
+    }
+
+    //! 将条目移出链表
+    void unlink(LruHook &h)
+    {
+        if (h.owner != this)
+            return;
+        h.prev->next = h.next, h.next->prev = h.prev;
+        h.prev = h.next = nullptr, h.owner = nullptr;
+        total -= h.bytes, count--;
+    }
+
+    //! 最久未出现的条目，链表为空时返回 `nullptr`
+    LruHook *oldest() { return head.next == &head ? nullptr : head.next; }
+
+    //! 链入条目的总字节数
+    size_t bytes() const { return total; }
+
+    //! 链入条目数
+    size_t size() const { return count; }
+
+private:
+    LruHook head;
+    size_t total{};
+    size_t count{};
+};
+
+inline LruHook::~LruHook()
+{
+    if (owner)
+        owner->unlink(*this);
+}
+
+struct EndpointInfo
+{
+    uint32_t topic_id{}; //!< 话题名驻留 ID，话题名只保存在驻留表中
+    bool is_pub;
+    Clock::time_point last_seen{}; //!< 最近一次收到 REDP 通告的时间
+    bool held{};                   //!< 已超时但因抖动抑制而保留
+    LruHook lru;                   //!< 内存预算 LRU 挂钩
+
+    /**
+     * @brief 计入内存预算的字节数（含哈希表结点开销的近似值）
+     * @param[in] names 驻留表，话题名在其中所占的字节计入每个引用它的端点
+     */
+    size_t footprint(const StringPool &names) const
+    {
+        return sizeof(std::pair<const uint64_t, EndpointInfo>) + 2 * sizeof(void *) +
+               StringPool::entry_bytes(names.str(topic_id).size());
+    }
+};
+
+/**
+ * @brief 节点心跳统计，根据 RNDP 通告的到达时间在线估计通告周期、抖动与丢失率
+ * @details 初始周期取前 `SEED` 个到达间隔的中位数，远短于周期估计的间隔视为重复报文而忽略。过长的间隔按周期的整数倍
+ *          拆分并计入丢失；若连续 `REESTIMATE` 个间隔都被拆分，说明周期估计只是真实周期的约数，以其中最短的间隔重新估计，
+ *          并撤销这些间隔计入的丢失
+ * @note 仅保存若干 EWMA 状态量，每个节点占用常数内存
+ */
+struct HeartbeatStats
+{
+    static constexpr int SEED = 3;                   //!< 用于估计初始周期的到达间隔数
+    static constexpr int REESTIMATE = 8;             //!< 连续被拆分的间隔达到该数目时重新估计周期
+    static constexpr double DUPLICATE_RATIO = 0.25;  //!< 短于周期估计该比例的间隔视为重复报文
+    static constexpr double MAX_SPLIT = 1 << 16;     //!< 单个间隔最多拆分的份数
+
+    Clock::time_point first_seen{}; //!< 首次收到通告的时间
+    Clock::time_point last_seen{};  //!< 最近一次收到通告的时间
+    double period{};                //!< 估计的通告周期（秒），收集满 `SEED` 个间隔前为其中的最大值
+    double jitter{};                //!< 到达间隔相对周期的平均偏差（秒）
+    double loss{};                  //!< 心跳丢失率的 EWMA 估计
+    uint64_t received{};            //!< 收到的通告总数，含被忽略的重复报文
+    uint64_t missed{};              //!< 推断丢失的通告总数
+
+    /**
+     * @brief 记录一次通告的到达
+     * @param[in] now 到达时间
+     */
+    void update(Clock::time_point now)
+    {
+        if (received++ == 0)
+        {
+            first_seen = last_seen = now;
+            return;
+        }
+        double dt = std::chrono::duration<double>(now - last_seen).count();
+        // 重复或立即重发的通告不推进最近通告时间，下一个间隔仍从原通告算起
+        if (dt < period * DUPLICATE_RATIO)
+            return;
+        last_seen = now;
+        if (seeded < SEED)
+        {
+            seed[seeded++] = dt;
+            period = seeded < SEED ? std::max(period, dt) : median(seed);
+            return;
+        }
+        // 以当前周期估计推断间隔内丢失的通告数，过长的间隔按周期整数倍拆分
+        int k = std::max(1, static_cast<int>(std::lround(std::min(dt / period, MAX_SPLIT))));
+        double interval = dt / k;
+        // 随机丢失造成的间隔长短不一，周期估计偏小时被拆分的间隔则彼此相近
+        if (k == 1 || (streak && std::max(dt, streak_max) > 1.5 * std::min(dt, streak_min)))
+            streak = 0;
+        if (k > 1 && streak++ == 0)
+        {
+            streak_min = streak_max = dt;
+            streak_missed = 0;
+            streak_loss = loss;
+        }
+        missed += k - 1;
+        period += (interval - period) / 8;
+        jitter += (std::abs(interval - period) - jitter) / 16;
+        loss += (static_cast<double>(k - 1) / k - loss) / 8;
+        if (k == 1)
+            return;
+        streak_min = std::min(streak_min, dt);
+        streak_max = std::max(streak_max, dt);
+        streak_missed += k - 1;
+        if (streak >= REESTIMATE)
+        {
+            period = streak_min;
+            missed -= streak_missed;
+            loss = streak_loss * std::pow(7.0 / 8, streak);
+            streak = 0;
+        }
+    }
+
+    //! 距离最近一次通告经过的时间（秒）
+    double age(Clock::time_point now) const { return std::chrono::duration<double>(now - last_seen).count(); }
+
+    //! 是否已错过预期的下一次通告，周期尚未估计时以 1 s 为界
+    bool overdue(Clock::time_point now) const { return age(now) > (period > 0 ? period + 4 * jitter + 0.05 : 1.0); }
+
+    /**
+     * @brief 节点健康状况的简短标记
+     * @param[in] now 当前时间
+     * @return 即将超时返回 `EXPIRING`，已错过预期心跳返回 `LATE`，丢失率偏高返回 `LOSSY`，否则返回空串
+     */
+    const char *health(Clock::time_point now) const { return health_of(age(now), period, jitter, loss); }
+
+    //! 由各项统计量判断节点健康状况，参见 `health`
+    static const char *health_of(double age, double period, double jitter, double loss)
+    {
+        if (age >= std::chrono::duration<double>(NODE_TTL).count() / 2)
+            return "EXPIRING";
+        if (period > 0 && age > period + 4 * jitter + 0.05)
+            return "LATE";
+        if (loss >= 0.1)
+            return "LOSSY";
+        return "";
+    }
+
+private:
+    static double median(const double (&v)[SEED])
+    {
+        double sorted[SEED];
+        std::copy(v, v + SEED, sorted);
+        std::nth_element(sorted, sorted + SEED / 2, sorted + SEED);
+        return sorted[SEED / 2];
+    }
+
+    double seed[SEED]{};      //!< 用于估计初始周期的到达间隔（秒）
+    int seeded{};             //!< 已收集的初始间隔数
+    int streak{};             //!< 连续被拆分的间隔数
+    double streak_min{};      //!< 这些间隔中最短者（秒）
+    double streak_max{};      //!< 这些间隔中最长者（秒）
+    uint64_t streak_missed{}; //!< 这些间隔计入的丢失数
+    double streak_loss{};     //!< 这些间隔之前的丢失率估计
+};
+
+/**
+ * @brief 指数衰减的事件速率计，时间常数为 1 分钟
+ */
+struct RateMeter
+{
+    static constexpr double TAU = 60.0;
+
+    double value{};           //!< 衰减后的事件累计值
+    Clock::time_point last{}; //!< 最近一次更新的时间
+
+    //! 记录 `n` 次事件
+    void add(Clock::time_point now, double n = 1) { value = decayed(now) + n, last = now; }
+
+    //! 每分钟事件数
+    double per_minute(Clock::time_point now) const { return decayed(now) / TAU * 60; }
+
+    //! 每秒事件数
+    double per_second(Clock::time_point now) const { return decayed(now) / TAU; }
+
+private:
+    double decayed(Clock::time_point now) const
+    {
+        return value * std::exp(-std::chrono::duration<double>(now - last).count() / TAU);
+    }
+};
+
+/**
+ * @brief 发现协议报文的开销计量
+ * @details 字节数计入以太网、IPv4 与 UDP 头，反映报文实际占用的链路带宽；处理耗时为检查器解析并更新状态的时间，
+ *          不含等待状态锁的时间
+ */
+struct DiscoveryCost
+{
+    static constexpr size_t HEADER_BYTES = 14 + 20 + 8; //!< 以太网、IPv4 与 UDP 头的字节数
+
+    RateMeter bytes;         //!< 链路字节数
+    RateMeter packets;       //!< 报文数
+    RateMeter cpu_ns;        //!< 处理耗时（纳秒）
+    uint64_t total_bytes{};   //!< 累计链路字节数
+    uint64_t total_packets{}; //!< 累计报文数
+    uint64_t total_ns{};      //!< 累计处理耗时（纳秒）
+
+    /**
+     * @brief 记录一个报文
+     * @param[in] now 当前时间
+     * @param[in] payload UDP 载荷字节数
+     * @param[in] ns 处理耗时（纳秒）
+     */
+    void add(Clock::time_point now, size_t payload, uint64_t ns)
+    {
+        size_t wire = payload + HEADER_BYTES;
+        bytes.add(now, static_cast<double>(wire));
+        packets.add(now);
+        cpu_ns.add(now, static_cast<double>(ns));
+        total_bytes += wire;
+        total_packets++;
+        total_ns += ns;
+    }
+};
+
+/**
+ * @brief 单个条目的抖动记录
+ */
+struct FlapRecord
+{
+    double penalty{};            //!< 当前惩罚值
+    Clock::time_point updated{}; //!< 惩罚值最近一次衰减的时间
+    bool suppressed{};           //!< 是否处于抑制状态
+    uint64_t flaps{};            //!< 累计抖动次数
+    RateMeter rate;              //!< 抖动速率
+};
+
+/**
+ * @brief 抖动抑制器，参照 BGP 路由抖动抑制 (RFC 2439) 的惩罚值模型
+ * @details
+ * - 条目每次失效累加 `PENALTY`，惩罚值按 `HALF_LIFE` 指数衰减
+ * - 惩罚值超过 `SUPPRESS` 时进入抑制状态，低于 `REUSE` 时解除抑制
+ * - 处于抑制状态的条目在失效时被保留而非拆除，重新出现时无需重新发现
+ */
+struct FlapDamper
+{
+    static constexpr double PENALTY = 1000;
+    static constexpr double SUPPRESS = 2000;
+    static constexpr double REUSE = 750;
+    static constexpr double MAX_PENALTY = 4 * SUPPRESS;
+    static constexpr double HALF_LIFE = 30.0;
+
+    std::unordered_map<uint64_t, FlapRecord> records;
+    size_t max_records{}; //!< 记录数上限，为 0 时不限制
+
+    /**
+     * @brief 记录一次失效
+     * @param[in] key 条目标识
+     * @param[in] now 当前时间
+     * @return 条目是否处于抑制状态
+     */
+    bool flap(uint64_t key, Clock::time_point now)
+    {
+        // 记录数达到上限时不再跟踪新条目，避免垃圾流量撑爆内存
+        if (max_records && records.size() >= max_records && !records.count(key))
+            return false;
+        auto &r = records[key];
+        decay(r, now);
+        r.penalty = std::min(r.penalty + PENALTY, MAX_PENALTY);
+        r.flaps++;
+        r.rate.add(now);
+        if (r.penalty >= SUPPRESS)
+            r.suppressed = true;
+        return r.suppressed;
+    }
+
+    /**
+     * @brief 查询条目是否仍处于抑制状态
+     * @param[in] key 条目标识
+     * @param[in] now 当前时间
+     */
+    bool suppressed(uint64_t key, Clock::time_point now)
+    {
+        auto it = records.find(key);
+        if (it == records.end())
+            return false;
+        decay(it->second, now);
+        return it->second.suppressed;
+    }
+
+    //! 清除惩罚值已衰减至可忽略的记录
+    void prune(Clock::time_point now)
+    {
+        for (auto it = records.begin(); it != records.end();)
+        {
+            decay(it->second, now);
+            if (!it->second.suppressed && it->second.penalty < REUSE / 2)
+                it = records.erase(it);
+            else
+                ++it;
+        }
+    }
+
+private:
+    static void decay(FlapRecord &r, Clock::time_point now)
+    {
+        double dt = std::chrono::duration<double>(now - r.updated).count();
+        r.penalty *= std::exp2(-dt / HALF_LIFE);
+        r.updated = now;
+        if (r.suppressed && r.penalty < REUSE)
+            r.suppressed = false;
+    }
+};
+
+/**
+ * @brief 多分辨率时间序列
+ * @details 以 1 s、1 min、1 h 三种分辨率分别保存于定长环形缓冲区，每 60 个低层采样取均值降采样为 1
+ *          个高层采样。每条序列占用常数内存，写入为 O(1)
+ */
+class TimeSeries
+{
+public:
+    static constexpr size_t LEVELS = 3;
+    static constexpr size_t CAPACITY[LEVELS] = {120, 120, 48}; //!< 各分辨率保存的采样数
+    static constexpr const char *LABELS[LEVELS] = {"1s", "1m", "1h"};
+
+    //! 写入一个 1 s 采样
+    void push(double v)
+    {
+        sec.push(static_cast<float>(v));
+        if (min_acc.add(v))
+        {
+            double m = min_acc.take();
+            min.push(static_cast<float>(m));
+            if (hour_acc.add(m))
+                hour.push(static_cast<float>(hour_acc.take()));
+        }
+    }
+
+    /**
+     * @brief 读取某一分辨率下最近的采样
+     * @param[in] level 分辨率级别，0 为 1 s，1 为 1 min，2 为 1 h
+     * @param[in] n 最多读取的采样数
+     * @return 由旧到新排列的采样
+     */
+    std::vector<float> recent(size_t level, size_t n) const
+    {
+        switch (level)
+        {
+        case 0:
+            return sec.recent(n);
+        case 1:
+            return min.recent(n);
+        default:
+            return hour.recent(n);
+        }
+    }
+
+private:
+    template <size_t N>
+    struct Ring
+    {
+        std::array<float, N> buf{};
+        size_t head{}; //!< 下一次写入的位置
+        size_t size{};
+
+        void push(float v)
+        {
+            buf[head] = v;
+            head = (head + 1) % N;
+            size = std::min(size + 1, N);
+        }
+
+        std::vector<float> recent(size_t n) const
+        {
+            n = std::min(n, size);
+            std::vector<float> res(n);
+            for (size_t i = 0; i < n; i++)
+                res[i] = buf[(head + N - n + i) % N];
+            return res;
+        }
+    };
+
+    //! 降采样累加器，每 60 个采样输出一次均值
+    struct Accumulator
+    {
+        double sum{};
+        int n{};
+
+        bool add(double v) { return sum += v, ++n == 60; }
+        double take() { return std::exchange(sum, 0) / std::exchange(n, 0); }
+    };
+
+    Ring<CAPACITY[0]> sec;
+    Ring<CAPACITY[1]> min;
+    Ring<CAPACITY[2]> hour;
+    Accumulator min_acc;
+    Accumulator hour_acc;
+};
+
+//! 节点指标的历史记录
+struct NodeHistory
+{
+    TimeSeries endpoints; //!< 端点数
+    TimeSeries rate;      //!< 通告速率 (Hz)
+    TimeSeries jitter;    //!< 通告抖动 (ms)
+    TimeSeries loss;      //!< 心跳丢失率 (%)
+};
+
+//! 话题指标的历史记录
+struct TopicHistory
+{
+    TimeSeries pubs; //!< 发布者数
+    TimeSeries subs; //!< 订阅者数
+};
+
+/**
+ * @brief 节点的列式视图
+ * @details 每个属性保存为一个连续数组，过滤表达式按列批量求值；各节点所含端点的话题以 CSR 形式保存。
+ *          `MonitorState::columns` 随节点与端点的增减增量维护，其中 `AGE` 列与话题不维护，由 `copy_columns`
+ *          在复制时填充
+ */
+struct NodeColumns
+{
+    enum Field : uint8_t
+    {
+        PUBS,
+        SUBS,
+        EPS,
+        AGE,
+        PERIOD,
+        JITTER,
+        LOSS,
+        HELD,
+        FIELD_COUNT
+    };
+
+    std::vector<uint64_t> prefix;                     //!< 节点 GUID 前缀
+    std::vector<uint32_t> name;                       //!< 节点名驻留 ID
+    std::array<std::vector<double>, FIELD_COUNT> num; //!< 数值列
+    std::vector<uint32_t> topic_begin;                //!< 第 i 个节点的话题位于 `topics[topic_begin[i], topic_begin[i + 1])`
+    std::vector<uint32_t> topics;                     //!< 话题名驻留 ID
+    std::vector<Clock::time_point> last_seen;         //!< 最近一次收到通告的时间，用于计算 `AGE`
+
+    //! 每行占用的字节数
+    static constexpr size_t ROW_BYTES = sizeof(uint64_t) + sizeof(uint32_t) + FIELD_COUNT * sizeof(double) +
+                                        sizeof(Clock::time_point);
+
+    size_t size() const { return prefix.size(); }
+
+    //! 追加一行，各列置零，返回其行号
+    uint32_t add(uint64_t key)
+    {
+        prefix.push_back(key);
+        name.push_back(0);
+        for (auto &col : num)
+            col.push_back(0);
+        last_seen.emplace_back();
+        return static_cast<uint32_t>(prefix.size() - 1);
+    }
+
+    /**
+     * @brief 删除一行，以末行填补其位置
+     * @param[in] row 行号
+     * @note 若 `row < size()`，原末行已移至 `row`，调用方需更新其所属节点记录的行号
+     */
+    void remove(uint32_t row)
+    {
+        auto pop = [row](auto &col) {
+            col[row] = col.back();
+            col.pop_back();
+        };
+        pop(prefix);
+        pop(name);
+        for (auto &col : num)
+            pop(col);
+        pop(last_seen);
+    }
+};
+
+struct NodeInfo
+{
+    uint32_t name_id{}; //!< 节点名驻留 ID，节点名只保存在驻留表中
+    HeartbeatStats hb;
+    bool held{};                          //!< 已超时但因抖动抑制而保留
+    LruHook lru;                          //!< 内存预算 LRU 挂钩
+    std::unique_ptr<NodeHistory> history; //!< 指标历史，首次采样时分配
+    uint64_t identity{};                  //!< 身份键，由节点名与定位器地址决定，进程重启后不变
+    DiscoveryCost cost;                   //!< 本节点的 RNDP 通告与其端点的 REDP 报文的开销
+    uint32_t row{};                       //!< 在 `MonitorState::columns` 中的行号
+    uint64_t locator{};                   //!< 通告的 REDP 定位器，见 `locator_key()`，无定位器时为 0
+
+    /**
+     * @brief 计入内存预算的字节数（含哈希表结点开销的近似值）
+     * @param[in] names 驻留表，节点名在其中所占的字节计入每个引用它的节点
+     */
+    size_t footprint(const StringPool &names) const
+    {
+        return sizeof(std::pair<const uint64_t, NodeInfo>) + 2 * sizeof(void *) + StringPool::entry_bytes(names.str(name_id).size()) +
+               NodeColumns::ROW_BYTES + (locator ? sizeof(std::pair<const uint64_t, uint32_t>) + 2 * sizeof(void *) : 0) +
+               (history ? sizeof(NodeHistory) : 0);
+    }
+};
+
+/**
+ * @brief 拓扑快照，节点与端点均以按 GUID 排序的驻留 ID 数组保存，便于线性归并比较
+ */
+struct Snapshot
+{
+    struct Node
+    {
+        uint64_t prefix;
+        uint32_t name;
+    };
+
+    struct Endpoint
+    {
+        uint64_t guid;
+        uint32_t topic;
+        bool is_pub;
+    };
+
+    std::vector<Node> nodes;         //!< 按 `prefix` 升序
+    std::vector<Endpoint> endpoints; //!< 按 `guid` 升序
+
+    //! 节点名 ID，节点不在快照中时返回 `UINT32_MAX`
+    uint32_t node_name(uint64_t prefix) const
+    {
+        auto it = std::lower_bound(nodes.begin(), nodes.end(), prefix, [](const Node &n, uint64_t p) { return n.prefix < p; });
+        return it != nodes.end() && it->prefix == prefix ? it->name : UINT32_MAX;
+    }
+};
+
+/**
+ * @brief 数据流可达性索引，回答经由 发布者→话题→订阅者 链路数据能够流向哪些节点
+ * @details
+ * - 节点占用稠密槽位，话题以名称的驻留 ID 为键，每个话题以两个稀疏的槽位列表记录其发布者与订阅者，端点增删时增量
+ *   维护，索引的内存与链路数成正比
+ * - 节点 u 的后继为其所发布话题的订阅者之并，查询时以按槽位编址的位集记录访问状态做 BFS，每个话题至多展开一次
+ * - 各源节点的传递闭包按需缓存。拓扑变化时只累积出边发生改变的节点，查询前丢弃源节点或可达集与之相交的缓存，
+ *   其余连通部分的缓存继续有效；缓存总量超过上限时全部丢弃
+ */
+class ReachIndex
+{
+public:
+    using Bits = std::vector<uint64_t>;
+
+    /**
+     * @brief 记录节点 `prefix` 在话题上的一个端点
+     * @param[in] prefix 节点 GUID 前缀
+     * @param[in] topic 话题名的驻留 ID
+     * @param[in] is_pub 是否为发布者
+     */
+    void add_endpoint(uint64_t prefix, uint32_t topic, bool is_pub)
+    {
+        uint32_t s = slot_of(prefix);
+        uint32_t t = topic_of(topic);
+        auto &list = is_pub ? slots[s].pubs : slots[s].subs;
+        for (auto &[id, count] : list)
+            if (id == t)
+            {
+                count++;
+                return;
+            }
+        list.emplace_back(t, 1);
+        topics[t].refs++;
+        (is_pub ? topics[t].pubs : topics[t].subs).push_back(s);
+        links++;
+        mark_dirty(s, t, is_pub);
+    }
+
+    //! 移除节点 `prefix` 在话题 `topic`（驻留 ID）上的一个端点
+    void remove_endpoint(uint64_t prefix, uint32_t topic, bool is_pub)
+    {
+        auto sit = slot_ids.find(prefix);
+        auto tit = topic_ids.find(topic);
+        if (sit == slot_ids.end() || tit == topic_ids.end())
+            return;
+        uint32_t s = sit->second, t = tit->second;
+        auto &list = is_pub ? slots[s].pubs : slots[s].subs;
+        for (auto it = list.begin(); it != list.end(); ++it)
+            if (it->first == t)
+            {
+                if (--it->second == 0)
+                {
+                    list.erase(it);
+                    unlink(s, t, is_pub);
+                    release_slot_if_empty(s);
+                }
+                return;
+            }
+    }
+
+    //! 移除节点的全部端点
+    void remove_node(uint64_t prefix)
+    {
+        auto sit = slot_ids.find(prefix);
+        if (sit == slot_ids.end())
+            return;
+        uint32_t s = sit->second;
+        for (auto &[t, count] : std::exchange(slots[s].pubs, {}))
+            unlink(s, t, true);
+        for (auto &[t, count] : std::exchange(slots[s].subs, {}))
+            unlink(s, t, false);
+        release_slot_if_empty(s);
+    }
+
+    //! 从节点 `prefix` 出发数据可达的全部节点（存在环路时包含其自身）
+    std::vector<uint64_t> downstream(uint64_t prefix)
+    {
+        std::vector<uint64_t> res;
+        auto sit = slot_ids.find(prefix);
+        if (sit == slot_ids.end())
+            return res;
+        auto &row = closure(sit->second);
+        for (size_t w = 0; w < row.size(); w++)
+            for (uint64_t bits = row[w]; bits; bits &= bits - 1)
+                res.push_back(slots[w * 64 + __builtin_ctzll(bits)].prefix);
+        return res;
+    }
+
+    /**
+     * @brief 求 `from` 到 `to` 的最短数据流路径
+     * @return 路径上依次经过的 (话题名驻留 ID, 节点)，首项话题为 `UINT32_MAX`；不可达时返回空数组
+     */
+    std::vector<std::pair<uint32_t, uint64_t>> path(uint64_t from, uint64_t to)
+    {
+        std::vector<std::pair<uint32_t, uint64_t>> res;
+        auto fit = slot_ids.find(from), tit = slot_ids.find(to);
+        if (fit == slot_ids.end() || tit == slot_ids.end())
+            return res;
+        uint32_t src = fit->second, dst = tit->second;
+        // 仅在缓存的闭包表明可达时才做带前驱记录的 BFS
+        if (src != dst && !test(closure(src), dst))
+            return res;
+
+        size_t words = (slots.size() + 63) / 64;
+        Bits visited(words), frontier(words);
+        std::vector<std::pair<uint32_t, uint32_t>> parent(slots.size()); // 槽位 -> (前驱槽位, 话题)
+        std::vector<bool> topic_seen(topics.size());
+        set(frontier, src);
+        bool found = false;
+        while (!found && any(frontier))
+        {
+            Bits next(words);
+            for (uint32_t u : ones(frontier))
+                for (auto &[t, count] : slots[u].pubs)
+                {
+                    if (topic_seen[t])
+                        continue;
+                    topic_seen[t] = true;
+                    for (uint32_t v : topics[t].subs)
+                        if (!test(visited, v))
+                        {
+                            set(visited, v), set(next, v);
+                            parent[v] = {u, t};
+                        }
+                }
+            found = test(visited, dst);
+            frontier = std::move(next);
+        }
+        if (!found)
+            return res;
+        uint32_t v = dst;
+        do
+        {
+            res.emplace_back(topics[parent[v].second].name, slots[v].prefix);
+            v = parent[v].first;
+        } while (v != src);
+        res.emplace_back(UINT32_MAX, slots[src].prefix);
+        std::reverse(res.begin(), res.end());
+        return res;
+    }
+
+    /**
+     * @brief 驻留表紧凑后重映射话题名 ID
+     * @param[in] remap 旧 ID 到新 ID 的映射，索引中的话题均须仍在使用
+     */
+    void remap_names(const std::vector<uint32_t> &remap)
+    {
+        std::unordered_map<uint32_t, uint32_t> ids;
+        ids.reserve(topic_ids.size());
+        for (auto &[name, t] : topic_ids)
+            ids.emplace(topics[t].name = remap[name], t);
+        topic_ids = std::move(ids);
+    }
+
+    //! 设置传递闭包缓存的字节数上限，为 0 时不限制
+    void set_cache_limit(size_t bytes) { cache_limit = bytes; }
+
+    /**
+     * @brief 索引结构占用的字节数（近似），随节点、话题与链路数增减，O(1)
+     * @note 不含传递闭包缓存，后者由 `set_cache_limit()` 单独限制
+     */
+    size_t bytes() const
+    {
+        constexpr size_t MAP_NODE = sizeof(std::pair<const uint64_t, uint32_t>) + 2 * sizeof(void *);
+        constexpr size_t LINK = sizeof(std::pair<uint32_t, uint32_t>) + sizeof(uint32_t);
+        return slot_ids.size() * (MAP_NODE + sizeof(Slot) + sizeof(Bits)) + topic_ids.size() * (MAP_NODE + sizeof(Topic)) +
+               links * LINK;
+    }
+
+    //! 传递闭包缓存占用的字节数
+    size_t cache_bytes() const { return cache_words * sizeof(uint64_t); }
+
+private:
+    struct Slot
+    {
+        uint64_t prefix{};
+        std::vector<std::pair<uint32_t, uint32_t>> pubs; //!< (话题, 端点数)
+        std::vector<std::pair<uint32_t, uint32_t>> subs; //!< (话题, 端点数)
+    };
+
+    struct Topic
+    {
+        uint32_t name{};            //!< 话题名驻留 ID
+        std::vector<uint32_t> pubs; //!< 发布者槽位
+        std::vector<uint32_t> subs; //!< 订阅者槽位
+        size_t refs{};              //!< 引用该话题的 (节点, 方向) 数
+    };
+
+    static void set(Bits &b, uint32_t i)
+    {
+        if (b.size() <= i / 64)
+            b.resize(i / 64 + 1);
+        b[i / 64] |= 1ULL << (i % 64);
+    }
+    static bool test(const Bits &b, uint32_t i) { return b.size() > i / 64 && (b[i / 64] >> (i % 64) & 1); }
+    static bool any(const Bits &b)
+    {
+        return std::any_of(b.begin(), b.end(), [](uint64_t w) { return w != 0; });
+    }
+    static std::vector<uint32_t> ones(const Bits &b)
+    {
+        std::vector<uint32_t> res;
+        for (size_t w = 0; w < b.size(); w++)
+            for (uint64_t bits = b[w]; bits; bits &= bits - 1)
+                res.push_back(static_cast<uint32_t>(w * 64 + __builtin_ctzll(bits)));
+        return res;
+    }
+
+    uint32_t slot_of(uint64_t prefix)
+    {
+        auto [it, inserted] = slot_ids.try_emplace(prefix);
+        if (inserted)
+        {
+            if (free_slots.empty())
+            {
+                it->second = static_cast<uint32_t>(slots.size());
+                slots.emplace_back();
+                cached.emplace_back();
+                rows.emplace_back();
+            }
+            else
+            {
+                it->second = free_slots.back();
+                free_slots.pop_back();
+            }
+            slots[it->second].prefix = prefix;
+        }
+        return it->second;
+    }
+
+    uint32_t topic_of(uint32_t name)
+    {
+        auto [it, inserted] = topic_ids.try_emplace(name);
+        if (inserted)
+        {
+            if (free_topics.empty())
+            {
+                it->second = static_cast<uint32_t>(topics.size());
+                topics.emplace_back();
+            }
+            else
+            {
+                it->second = free_topics.back();
+                free_topics.pop_back();
+            }
+            topics[it->second].name = name;
+        }
+        return it->second;
+    }
+
+    /**
+     * @brief 记录出边发生改变的节点
+     * @note 发布端点变化改变节点自身的出边；订阅端点变化改变该话题所有发布者的出边
+     */
+    void mark_dirty(uint32_t s, uint32_t t, bool is_pub)
+    {
+        if (is_pub)
+            set(dirty, s);
+        else
+            for (uint32_t p : topics[t].pubs)
+                set(dirty, p);
+    }
+
+    void unlink(uint32_t s, uint32_t t, bool is_pub)
+    {
+        mark_dirty(s, t, is_pub);
+        auto &topic = topics[t];
+        auto &list = is_pub ? topic.pubs : topic.subs;
+        auto it = std::find(list.begin(), list.end(), s);
+        if (it != list.end())
+        {
+            *it = list.back();
+            list.pop_back();
+            links--;
+        }
+        if (--topic.refs == 0)
+        {
+            topic_ids.erase(topic.name);
+            topic = {};
+            free_topics.push_back(t);
+        }
+    }
+
+    void release_slot_if_empty(uint32_t s)
+    {
+        if (!slots[s].pubs.empty() || !slots[s].subs.empty())
+            return;
+        slot_ids.erase(slots[s].prefix);
+        drop_row(s);
+        free_slots.push_back(s);
+    }
+
+    //! 丢弃槽位缓存的传递闭包并释放其内存
+    void drop_row(size_t s)
+    {
+        cached[s] = false;
+        cache_words -= rows[s].size();
+        Bits().swap(rows[s]);
+    }
+
+    //! 节点的传递闭包，必要时先使失效的缓存作废
+    const Bits &closure(uint32_t s)
+    {
+        if (any(dirty))
+        {
+            for (size_t r = 0; r < rows.size(); r++)
+            {
+                if (!cached[r])
+                    continue;
+                bool stale = test(dirty, static_cast<uint32_t>(r));
+                for (size_t w = 0; !stale && w < std::min(dirty.size(), rows[r].size()); w++)
+                    stale = rows[r][w] & dirty[w];
+                if (stale)
+                    drop_row(r);
+            }
+            std::fill(dirty.begin(), dirty.end(), 0);
+        }
+        if (cached[s])
+            return rows[s];
+
+        size_t words = (slots.size() + 63) / 64;
+        Bits row(words), frontier(words);
+        std::vector<bool> topic_seen(topics.size());
+        set(frontier, s);
+        while (any(frontier))
+        {
+            Bits next(words);
+            for (uint32_t u : ones(frontier))
+                for (auto &[t, count] : slots[u].pubs)
+                {
+                    if (topic_seen[t])
+                        continue;
+                    topic_seen[t] = true;
+                    for (uint32_t v : topics[t].subs)
+                        if (!test(row, v))
+                            set(row, v), set(next, v);
+                }
+            frontier = std::move(next);
+        }
+        if (cache_limit && (cache_words + words) * sizeof(uint64_t) > cache_limit)
+            for (size_t r = 0; r < rows.size(); r++)
+                if (cached[r])
+                    drop_row(r);
+        cached[s] = true;
+        cache_words += words;
+        return rows[s] = std::move(row);
+    }
+
+    std::unordered_map<uint64_t, uint32_t> slot_ids;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> free_slots;
+    std::unordered_map<uint32_t, uint32_t> topic_ids; //!< 话题名驻留 ID -> 话题
+    std::vector<Topic> topics;
+    std::vector<uint32_t> free_topics;
+    size_t links{}; //!< (节点, 话题, 方向) 链路数
+
+    std::vector<Bits> rows;    //!< 各槽位缓存的传递闭包
+    std::vector<bool> cached;  //!< 缓存是否有效
+    size_t cache_words{};      //!< 缓存的传递闭包的总字数
+    size_t cache_limit{};      //!< 缓存的字节数上限，为 0 时不限制
+    Bits dirty;                //!< 自上次查询以来出边改变的槽位
+};
+
+/**
+ * @brief 拓扑增量事件
+ * @note 节点名与话题名指向驻留表，只在回调期间有效，订阅者需要保存时自行复制
+ */
+struct TopologyEvent
+{
+    enum class Kind : uint8_t
+    {
+        NodeUp,          //!< 节点上线或重新出现
+        NodeDown,        //!< 节点超时或被移除
+        EndpointAdded,   //!< 新增端点
+        EndpointRemoved, //!< 移除端点
+    };
+
+    Kind kind;
+    uint64_t prefix;        //!< 节点 GUID 前缀
+    std::string_view name;  //!< 节点名，仅节点事件有效
+    std::string_view topic; //!< 话题名，仅端点事件有效
+    bool is_pub{};          //!< 端点类型，仅端点事件有效
+};
+
+/**
+ * @brief 全局监控状态
+ */
+struct MonitorState
+{
+    std::mutex mtx;
+    LruList lru; //!< 全部节点与端点按最近出现时间排序，须先于条目容器构造
+    std::unordered_map<uint64_t, NodeInfo> nodes;
+    //! 节点 GUID 前缀 -> (端点 GUID -> 端点信息)
+    std::unordered_map<uint64_t, std::unordered_map<uint64_t, EndpointInfo>> topics;
+    std::atomic<bool> running{};
+    Clock::duration endpoint_ttl{}; //!< 端点超时时间，为 0 时端点仅随节点超时或显式撤销而移除
+
+    FlapDamper node_flaps;     //!< 节点抖动抑制
+    FlapDamper endpoint_flaps; //!< 端点抖动抑制
+    RateMeter appear_rate;     //!< 全网节点上线速率
+    RateMeter expire_rate;     //!< 全网节点超时速率
+    uint64_t appear_total{};   //!< 节点上线总次数
+    uint64_t expire_total{};   //!< 节点超时总次数
+    uint64_t restart_total{};  //!< 识别出的节点重启总次数
+    DiscoveryCost discovery;   //!< 全网发现报文的开销，包括尚无对应节点的 REDP
+
+    std::unordered_map<uint64_t, uint64_t> identities;          //!< 身份键 -> 当前持有该身份的节点 GUID 前缀
+    std::unordered_set<uint64_t> superseded;                    //!< 被判定为重启前旧进程、待错过预期通告后回收的 GUID 前缀
+    std::unordered_map<uint64_t, Clock::time_point> retired;    //!< 因重启被回收的旧 GUID 前缀 -> 回收时刻，`NODE_TTL` 后清理
+    std::unordered_set<uint64_t> ambiguous;                     //!< 同时被多个存活节点使用的身份键，不再据此识别重启
+    std::unordered_map<uint64_t, uint32_t> locators;            //!< 存活节点通告的 REDP 定位器 -> 通告它的节点数，被动模式据此识别 REDP
+
+    size_t mem_cap{};             //!< 节点与端点的内存预算（字节），为 0 时不限制
+    uint64_t evicted_nodes{};     //!< 因超出预算被淘汰的节点数
+    uint64_t evicted_endpoints{}; //!< 因超出预算被淘汰的端点数，含随节点一并淘汰的端点
+    uint64_t evicted_bytes{};     //!< 淘汰释放的字节数
+
+    //! 每个话题的指标历史占用的字节数（含哈希表结点的近似值）
+    static constexpr size_t TOPIC_HISTORY_BYTES = sizeof(std::pair<const uint32_t, TopicHistory>) + 2 * sizeof(void *);
+
+    std::unordered_map<uint32_t, TopicHistory> topic_history; //!< 话题名驻留 ID -> 指标历史，话题消失或被淘汰时移除
+    size_t max_topic_history{};                               //!< 保留指标历史的话题数上限，为 0 时不限制
+
+    ReachIndex reach;                      //!< 数据流可达性索引
+    NodeColumns columns;                   //!< 节点列式视图，随节点与端点增减维护，行号记于 `NodeInfo::row`
+    //! 拓扑增量事件的订阅者及其订阅 ID，在持有 `mtx` 时同步调用
+    std::vector<std::pair<size_t, std::function<void(const TopologyEvent &)>>> observers;
+    size_t next_observer{};
+    StringPool names;                      //!< 节点名与话题名驻留表
+    CpuGovernor governor;                  //!< CPU 预算调节器，自带同步，无需持有 `mtx`
+    TrafficStats traffic;                  //!< 各收包线程的流量摘要，自带同步，无需持有 `mtx`
+    std::map<std::string, Snapshot> marks; //!< 具名拓扑快照
+
+    //! 计入内存预算 `mem_cap` 的字节数：节点、端点与可达性索引
+    size_t budget_bytes() const { return lru.bytes() + reach.bytes(); }
+};
+
+
+//! 节点 GUID 前缀，即 GUID 的低 48 位
+inline uint64_t get_prefix(const rm::lpss::Guid &g) { return g.full & 0xFFFFFFFFFFFFULL; }
+
+/**
+ * @brief 节点的身份键
+ * @param name 节点名
+ * @param addr 定位器 IPv4 地址（网络字节序）
+ */
+inline uint64_t identity_key(std::string_view name, uint32_t addr) { return hash64(name) ^ mix64(addr); }
+
+/**
+ * @brief 定位器的键，非零
+ * @param addr IPv4 地址（网络字节序）
+ * @param port 端口
+ */
+inline uint64_t locator_key(uint32_t addr, uint16_t port) { return 1ULL << 48 | uint64_t(addr) << 16 | port; }
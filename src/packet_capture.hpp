@@ -0,0 +1,233 @@
+/**
+ * @file packet_capture.hpp
+ * @author Nq139 (fnq409997@gmail.com)
+ * @brief 基于 TPACKET_V3 内存映射环的被动 UDP 抓包
+ * @copyright Copyright 2026, Nq139
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_packet.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "udp_receiver.hpp"
+
+/**
+ * @brief 被动 UDP 抓包
+ * @details 以 `AF_PACKET` 套接字配合 TPACKET_V3 块式接收环抓取经过本机网卡的 IPv4 UDP 报文：内核直接把报文写入与用户态
+ *          共享的内存块，一个块写满或超时后整块交给用户态，用户态逐个遍历块内报文后归还，全程无逐包系统调用与拷贝。
+ *          套接字本身不发送任何报文，内核侧以 BPF 过滤器丢弃非 UDP 报文
+ * @note 需要 `CAP_NET_RAW`。交换网络中只能看到发往本机的单播与组播报文，其他主机之间的单播需借助端口镜像，开启了 IGMP
+ *       侦听的交换机也不会转发本机未加入的组播；本机发出的报文可能被看到两次，此处只保留一份
+ */
+class PacketCapture
+{
+public:
+    static constexpr uint32_t BLOCK_SIZE = 1 << 20;  //!< 每个块的字节数
+    static constexpr uint32_t BLOCK_COUNT = 8;       //!< 块数
+    static constexpr uint32_t FRAME_SIZE = 2048;     //!< 帧大小，仅用于满足环的参数约束，块内报文实际按需紧凑排列
+    static constexpr uint32_t RETIRE_MS = 50;        //!< 未写满的块交给用户态的超时
+
+    /**
+     * @brief 打开抓包环
+     * @param[in] iface 网卡名，空表示全部网卡
+     * @param[out] err 失败原因
+     */
+    explicit PacketCapture(const std::string &iface, std::string &err)
+    {
+        fd = socket(AF_PACKET, SOCK_DGRAM, htons(ETH_P_IP));
+        if (fd < 0)
+        {
+            err = std::string("cannot open packet socket: ") + strerror(errno);
+            return;
+        }
+        // 协议字段（IP 头偏移 9）为 UDP 时接收整个报文，否则丢弃
+        sock_filter code[] = {
+            {BPF_LD | BPF_B | BPF_ABS, 0, 0, 9},
+            {BPF_JMP | BPF_JEQ | BPF_K, 0, 1, IPPROTO_UDP},
+            {BPF_RET | BPF_K, 0, 0, 0x40000},
+            {BPF_RET | BPF_K, 0, 0, 0},
+        };
+        sock_fprog prog{sizeof(code) / sizeof(code[0]), code};
+        int version = TPACKET_V3;
+        tpacket_req3 req{};
+        req.tp_block_size = BLOCK_SIZE;
+        req.tp_block_nr = BLOCK_COUNT;
+        req.tp_frame_size = FRAME_SIZE;
+        req.tp_frame_nr = BLOCK_SIZE / FRAME_SIZE * BLOCK_COUNT;
+        req.tp_retire_blk_tov = RETIRE_MS;
+        if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) != 0 ||
+            setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0 ||
+            setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) != 0)
+        {
+            err = std::string("cannot set up capture ring: ") + strerror(errno);
+            close(fd), fd = -1;
+            return;
+        }
+        ring = static_cast<uint8_t *>(mmap(nullptr, size_t(BLOCK_SIZE) * BLOCK_COUNT, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, fd, 0));
+        if (ring == MAP_FAILED) // 无权锁定内存时退回普通映射
+            ring = static_cast<uint8_t *>(mmap(nullptr, size_t(BLOCK_SIZE) * BLOCK_COUNT, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+        if (ring == MAP_FAILED)
+        {
+            err = std::string("cannot map capture ring: ") + strerror(errno);
+            ring = nullptr;
+            close(fd), fd = -1;
+            return;
+        }
+        sockaddr_ll addr{};
+        addr.sll_family = AF_PACKET;
+        addr.sll_protocol = htons(ETH_P_IP);
+        addr.sll_ifindex = iface.empty() ? 0 : static_cast<int>(if_nametoindex(iface.c_str()));
+        if ((!iface.empty() && !addr.sll_ifindex) || bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+        {
+            err = "cannot bind to interface '" + iface + "': " + strerror(errno ? errno : ENODEV);
+            munmap(ring, size_t(BLOCK_SIZE) * BLOCK_COUNT), ring = nullptr;
+            close(fd), fd = -1;
+            return;
+        }
+        // 不加入组播组（加入会发出 IGMP 报告），而是让网卡接收全部组播帧
+        if (addr.sll_ifindex)
+        {
+            packet_mreq mr{};
+            mr.mr_ifindex = addr.sll_ifindex;
+            mr.mr_type = PACKET_MR_ALLMULTI;
+            setsockopt(fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mr, sizeof(mr));
+        }
+    }
+
+    PacketCapture(PacketCapture &&other) noexcept : fd(other.fd), ring(other.ring), current(other.current), loopbacks(other.loopbacks)
+    {
+        other.fd = -1;
+        other.ring = nullptr;
+    }
+
+    PacketCapture(const PacketCapture &) = delete;
+    PacketCapture &operator=(const PacketCapture &) = delete;
+
+    ~PacketCapture()
+    {
+        if (ring)
+            munmap(ring, size_t(BLOCK_SIZE) * BLOCK_COUNT);
+        if (fd >= 0)
+            close(fd);
+    }
+
+    bool valid() const { return fd >= 0; }
+
+    /**
+     * @brief 等待下一个就绪的块，对其中每个 UDP 报文调用 `fn(const Datagram &)`，再把块归还内核
+     * @param[in] timeout 等待超时
+     * @return 本次处理的报文数
+     */
+    template <typename Fn>
+    size_t poll_block(Fn &&fn, std::chrono::milliseconds timeout)
+    {
+        auto *block = reinterpret_cast<tpacket_block_desc *>(ring + size_t(current) * BLOCK_SIZE);
+        if (!(block->hdr.bh1.block_status & TP_STATUS_USER))
+        {
+            pollfd pfd{fd, POLLIN | POLLERR, 0};
+            if (::poll(&pfd, 1, static_cast<int>(timeout.count())) <= 0 || !(block->hdr.bh1.block_status & TP_STATUS_USER))
+                return 0;
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        timespec real_now;
+        clock_gettime(CLOCK_REALTIME, &real_now);
+        auto steady_now = std::chrono::steady_clock::now();
+        size_t count = 0;
+        auto *pkt = reinterpret_cast<tpacket3_hdr *>(reinterpret_cast<uint8_t *>(block) + block->hdr.bh1.offset_to_first_pkt);
+        for (uint32_t i = 0; i < block->hdr.bh1.num_pkts; i++)
+        {
+            Datagram d;
+            if (parse(pkt, d))
+            {
+                auto delay = std::chrono::seconds(real_now.tv_sec - pkt->tp_sec) + std::chrono::nanoseconds(real_now.tv_nsec - pkt->tp_nsec);
+                d.sched_delay = std::max(delay, std::chrono::nanoseconds::zero());
+                d.arrival = steady_now - std::chrono::duration_cast<std::chrono::steady_clock::duration>(d.sched_delay);
+                d.kernel_ts = true;
+                fn(static_cast<const Datagram &>(d));
+                count++;
+            }
+            pkt = reinterpret_cast<tpacket3_hdr *>(reinterpret_cast<uint8_t *>(pkt) + pkt->tp_next_offset);
+        }
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        current = (current + 1) % BLOCK_COUNT;
+        return count;
+    }
+
+    //! 内核因环满而丢弃的报文数，读取后清零
+    uint64_t drops()
+    {
+        tpacket_stats_v3 st{};
+        socklen_t len = sizeof(st);
+        return getsockopt(fd, SOL_PACKET, PACKET_STATISTICS, &st, &len) == 0 ? st.tp_drops : 0;
+    }
+
+private:
+    //! 解析块内的一个报文，跳过环回接口上的发出副本、分片及残缺的报文
+    bool parse(const tpacket3_hdr *pkt, Datagram &d)
+    {
+        auto *ll = reinterpret_cast<const sockaddr_ll *>(reinterpret_cast<const uint8_t *>(pkt) + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+        // 本机发出的组播在发出网卡上另有一份环回副本，环回接口上的报文则发出、接收各一份，各只保留一份
+        if (ll->sll_pkttype == PACKET_LOOPBACK || (ll->sll_pkttype == PACKET_OUTGOING && is_loopback(ll->sll_ifindex)))
+            return false;
+        auto *ip = reinterpret_cast<const uint8_t *>(pkt) + pkt->tp_net;
+        uint32_t len = pkt->tp_snaplen;
+        if (len < 20 || (ip[0] >> 4) != 4)
+            return false;
+        uint32_t ihl = (ip[0] & 0x0F) * 4;
+        uint16_t frag = static_cast<uint16_t>(ip[6] << 8 | ip[7]);
+        if (frag & 0x3FFF || ihl < 20 || len < ihl + 8) // 只处理未分片的报文
+            return false;
+        auto *udp = ip + ihl;
+        uint32_t udp_len = static_cast<uint32_t>(udp[4] << 8 | udp[5]);
+        if (udp_len < 8 || ihl + udp_len > len)
+            return false;
+        memcpy(&d.addr, ip + 12, 4);
+        memcpy(&d.dst_addr, ip + 16, 4);
+        d.port = static_cast<uint16_t>(udp[0] << 8 | udp[1]);
+        d.dst_port = static_cast<uint16_t>(udp[2] << 8 | udp[3]);
+        d.data = std::string_view(reinterpret_cast<const char *>(udp + 8), udp_len - 8);
+        return true;
+    }
+
+    //! 网卡是否为环回接口，结果按网卡序号缓存
+    bool is_loopback(int ifindex)
+    {
+        if (ifindex <= 0 || ifindex >= 64)
+            return false;
+        uint64_t bit = 1ULL << ifindex;
+        if (!(loopbacks.known & bit))
+        {
+            ifreq ifr{};
+            if (if_indextoname(static_cast<unsigned>(ifindex), ifr.ifr_name) && ioctl(fd, SIOCGIFFLAGS, &ifr) == 0 && (ifr.ifr_flags & IFF_LOOPBACK))
+                loopbacks.flag |= bit;
+            loopbacks.known |= bit;
+        }
+        return loopbacks.flag & bit;
+    }
+
+    int fd{-1};
+    uint8_t *ring{};
+    uint32_t current{}; //!< 下一个待处理的块
+    struct
+    {
+        uint64_t known{}; //!< 已查询过的网卡
+        uint64_t flag{};  //!< 其中的环回接口
+    } loopbacks;
+};
@@ -0,0 +1,337 @@
+/**
+ * @file string_pool.hpp
+ * @author Nq139 (fnq409997@gmail.com)
+ * @brief 连续存储的字符串驻留表及其向量化子串/glob 检索
+ * @copyright Copyright 2026, Nq139
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <fnmatch.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LPSS_HAS_X86_SIMD 1
+#endif
+
+/**
+ * @brief 预处理的 glob 模式
+ * @note 仅含前导或尾随 `*` 的常见模式退化为前缀、后缀或子串比较，其余交由 `fnmatch` 处理
+ */
+struct GlobPattern
+{
+    enum class Kind : uint8_t
+    {
+        Exact,
+        Prefix,
+        Suffix,
+        Contains,
+        General,
+    };
+
+    Kind kind{Kind::Exact};
+    std::string pattern; //!< 原始模式
+    std::string literal; //!< 去除首尾 `*` 后的字面量
+
+    GlobPattern() = default;
+
+    explicit GlobPattern(std::string p) : pattern(std::move(p))
+    {
+        bool lead = !pattern.empty() && pattern.front() == '*';
+        bool trail = pattern.size() > lead && pattern.back() == '*';
+        literal = pattern.substr(lead, pattern.size() - lead - trail);
+        if (literal.find_first_of("*?[\\") != std::string::npos)
+            kind = Kind::General;
+        else
+            kind = lead ? (trail ? Kind::Contains : Kind::Suffix) : (trail ? Kind::Prefix : Kind::Exact);
+    }
+
+    bool match(std::string_view s) const
+    {
+        switch (kind)
+        {
+        case Kind::Exact:
+            return s == literal;
+        case Kind::Prefix:
+            return s.compare(0, literal.size(), literal) == 0;
+        case Kind::Suffix:
+            return s.size() >= literal.size() && s.compare(s.size() - literal.size(), literal.size(), literal) == 0;
+        case Kind::Contains:
+            return s.find(literal) != std::string_view::npos;
+        default:
+            return fnmatch(pattern.c_str(), std::string(s).c_str(), 0) == 0;
+        }
+    }
+
+    //! 模式中最长的一段不含通配符的字面量，用于检索前的预筛选
+    std::string_view longest_literal() const
+    {
+        std::string_view best, p = pattern;
+        size_t i = 0;
+        while (i < p.size())
+        {
+            size_t start = i;
+            while (i < p.size() && !strchr("*?[\\", p[i]))
+                i++;
+            if (i - start > best.size())
+                best = p.substr(start, i - start);
+            if (i < p.size() && p[i] == '[')
+                i = p.find(']', i + 1) == std::string_view::npos ? p.size() : p.find(']', i + 1);
+            i++;
+        }
+        return best;
+    }
+};
+
+/**
+ * @brief 字符串驻留表，为节点名与话题名分配稳定的整数 ID
+ * @details 全部字符串以 `'\0'` 分隔连续存放在同一块内存中，子串检索可对整块内存一次扫描完成：
+ *          以 SIMD 同时比较候选位置的首字节与末字节，只对两者均命中的位置逐字节核对（AVX2 / SSE2，其他平台使用
+ *          `memmem`），命中位置经偏移表二分映射回 ID
+ */
+class StringPool
+{
+public:
+    //! 驻留表内容的只读副本，不含查找索引，可在释放保护驻留表的锁之后按 ID 取字符串
+    struct View
+    {
+        std::string arena;
+        std::vector<uint32_t> offsets{0};
+
+        std::string_view str(uint32_t id) const { return {arena.data() + offsets[id], offsets[id + 1] - offsets[id] - 1}; }
+    };
+
+    StringPool() { offsets.push_back(0); }
+    StringPool(const StringPool &) = delete;
+    StringPool &operator=(const StringPool &) = delete;
+
+    //! 复制存储区与偏移表，开销与字符串总长成正比，不重建索引
+    View view() const { return {arena, offsets}; }
+
+    //! 长为 `len` 的字符串驻留后占用的字节数（含偏移表与索引项的近似值）
+    static constexpr size_t entry_bytes(size_t len)
+    {
+        return len + 1 + sizeof(uint32_t) + sizeof(std::pair<const std::string_view, uint32_t>) + 2 * sizeof(void *);
+    }
+
+    //! 获取字符串的 ID，不存在时分配新 ID
+    uint32_t intern(std::string_view s)
+    {
+        auto it = ids.find(s);
+        if (it != ids.end())
+            return it->second;
+        const char *old = arena.data();
+        arena.append(s).push_back('\0');
+        offsets.push_back(static_cast<uint32_t>(arena.size()));
+        uint32_t id = static_cast<uint32_t>(offsets.size() - 2);
+        // 存储区重新分配后原有视图全部失效，按倍增扩容摊还为 O(1)
+        if (arena.data() != old)
+            reindex();
+        else
+            ids.emplace(str(id), id);
+        return id;
+    }
+
+    //! 查找已驻留的字符串，不存在时返回 `UINT32_MAX`
+    uint32_t lookup(std::string_view s) const
+    {
+        auto it = ids.find(s);
+        return it != ids.end() ? it->second : UINT32_MAX;
+    }
+
+    //! 获取 ID 对应的字符串
+    std::string_view str(uint32_t id) const { return {arena.data() + offsets[id], offsets[id + 1] - offsets[id] - 1}; }
+
+    //! 获取 ID 对应的以 `'\0'` 结尾的字符串
+    const char *c_str(uint32_t id) const { return arena.data() + offsets[id]; }
+
+    //! 已分配的 ID 数
+    size_t size() const { return offsets.size() - 1; }
+
+    //! 占用的内存字节数（近似）
+    size_t bytes() const
+    {
+        return arena.capacity() + offsets.capacity() * sizeof(uint32_t) + ids.size() * (sizeof(std::string_view) + 24) +
+               ids.bucket_count() * sizeof(void *);
+    }
+
+    /**
+     * @brief 检索包含子串 `needle` 的全部字符串
+     * @param[in] needle 子串，不得含 `'\0'`
+     * @return 按升序排列的 ID
+     */
+    std::vector<uint32_t> find(std::string_view needle) const
+    {
+        std::vector<uint32_t> res;
+        if (needle.empty())
+        {
+            res.resize(size());
+            for (uint32_t i = 0; i < res.size(); i++)
+                res[i] = i;
+            return res;
+        }
+        uint32_t cursor = 0;
+#ifdef LPSS_HAS_X86_SIMD
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        size_t i = avx2 ? scan_avx2(needle, res, cursor) : scan_sse2(needle, res, cursor);
+#else
+        size_t i = 0;
+#endif
+        scan_scalar(i, needle, res, cursor);
+        return res;
+    }
+
+    /**
+     * @brief 检索匹配 glob 模式的全部字符串
+     * @note 先以模式中最长的字面量做向量化子串检索得到候选，再逐个核对完整模式
+     * @return 按升序排列的 ID
+     */
+    std::vector<uint32_t> glob(const GlobPattern &pattern) const
+    {
+        if (pattern.kind == GlobPattern::Kind::Exact)
+        {
+            uint32_t id = lookup(pattern.literal);
+            return id == UINT32_MAX ? std::vector<uint32_t>{} : std::vector<uint32_t>{id};
+        }
+        auto candidates = find(pattern.longest_literal());
+        if (pattern.kind == GlobPattern::Kind::Contains)
+            return candidates;
+        // 存储区中的字符串以 '\0' 结尾，一般模式可直接交给 fnmatch 而无需复制
+        auto miss = [&](uint32_t id) {
+            return pattern.kind == GlobPattern::Kind::General ? fnmatch(pattern.pattern.c_str(), c_str(id), 0) != 0
+                                                              : !pattern.match(str(id));
+        };
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(), miss), candidates.end());
+        return candidates;
+    }
+
+    /**
+     * @brief 丢弃不再使用的字符串并重新紧凑存放
+     * @param[in] live 各 ID 是否仍在使用，长度为 `size()`
+     * @return 旧 ID 到新 ID 的映射，被丢弃的 ID 映射为 `UINT32_MAX`
+     */
+    std::vector<uint32_t> compact(const std::vector<bool> &live)
+    {
+        std::vector<uint32_t> remap(size(), UINT32_MAX);
+        std::string packed;
+        std::vector<uint32_t> packed_offsets{0};
+        for (uint32_t id = 0; id < size(); id++)
+        {
+            if (!live[id])
+                continue;
+            remap[id] = static_cast<uint32_t>(packed_offsets.size() - 1);
+            packed.append(str(id)).push_back('\0');
+            packed_offsets.push_back(static_cast<uint32_t>(packed.size()));
+        }
+        arena = std::move(packed);
+        offsets = std::move(packed_offsets);
+        reindex();
+        return remap;
+    }
+
+private:
+    void reindex()
+    {
+        ids.clear();
+        ids.reserve(size());
+        for (uint32_t id = 0; id < size(); id++)
+            ids.emplace(str(id), id);
+    }
+
+    /**
+     * @brief 记录位置 `pos` 的命中
+     * @param[in] pos 命中位置，单次扫描中单调递增
+     * @param[out] res 命中的 ID
+     * @param[in,out] cursor 上一次命中的 ID，自此向后倍增查找，密集命中时均摊 O(1)
+     * @return 下一个字符串的起始位置，以跳过同一字符串内的其余命中
+     */
+    size_t hit(size_t pos, std::vector<uint32_t> &res, uint32_t &cursor) const
+    {
+        size_t lo = cursor, step = 1;
+        while (lo + step < offsets.size() && offsets[lo + step] <= pos)
+            lo += step, step *= 2;
+        auto hi = offsets.begin() + std::min(lo + step, offsets.size());
+        cursor = static_cast<uint32_t>(std::upper_bound(offsets.begin() + lo, hi, pos) - offsets.begin() - 1);
+        res.push_back(cursor);
+        return offsets[cursor + 1];
+    }
+
+    //! 自 `i` 起以 `memmem` 扫描余下部分
+    void scan_scalar(size_t i, std::string_view needle, std::vector<uint32_t> &res, uint32_t &cursor) const
+    {
+        while (i + needle.size() <= arena.size())
+        {
+            auto *p = static_cast<const char *>(memmem(arena.data() + i, arena.size() - i, needle.data(), needle.size()));
+            if (!p)
+                break;
+            i = hit(p - arena.data(), res, cursor);
+        }
+    }
+
+#ifdef LPSS_HAS_X86_SIMD
+    /**
+     * @brief 处理一块扫描结果：`mask` 的第 j 位表示位置 `i + j` 的首字节与末字节均与 `needle` 相同
+     * @return 下一块的起始位置
+     */
+    size_t check_block(size_t i, size_t width, uint32_t mask, std::string_view needle, std::vector<uint32_t> &res,
+                       uint32_t &cursor) const
+    {
+        size_t k = needle.size(), next = i + width;
+        while (mask)
+        {
+            size_t pos = i + __builtin_ctz(mask);
+            mask &= mask - 1;
+            if (k > 2 && memcmp(arena.data() + pos + 1, needle.data() + 1, k - 2))
+                continue;
+            size_t end = hit(pos, res, cursor);
+            if (end >= next)
+                return end;
+            mask &= ~0U << (end - i);
+        }
+        return next;
+    }
+
+    //! 以 32 字节为一块扫描，返回未扫描部分的起始位置
+    __attribute__((target("avx2"))) size_t scan_avx2(std::string_view needle, std::vector<uint32_t> &res, uint32_t &cursor) const
+    {
+        const char *data = arena.data();
+        size_t n = arena.size(), k = needle.size(), i = 0;
+        const __m256i first = _mm256_set1_epi8(needle[0]), last = _mm256_set1_epi8(needle[k - 1]);
+        while (i + k - 1 + 32 <= n)
+        {
+            __m256i bf = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+            __m256i bl = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + k - 1));
+            uint32_t mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(bf, first), _mm256_cmpeq_epi8(bl, last)));
+            i = mask ? check_block(i, 32, mask, needle, res, cursor) : i + 32;
+        }
+        return i;
+    }
+
+    //! 以 16 字节为一块扫描，返回未扫描部分的起始位置
+    size_t scan_sse2(std::string_view needle, std::vector<uint32_t> &res, uint32_t &cursor) const
+    {
+        const char *data = arena.data();
+        size_t n = arena.size(), k = needle.size(), i = 0;
+        const __m128i first = _mm_set1_epi8(needle[0]), last = _mm_set1_epi8(needle[k - 1]);
+        while (i + k - 1 + 16 <= n)
+        {
+            __m128i bf = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            __m128i bl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + k - 1));
+            uint32_t mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(bf, first), _mm_cmpeq_epi8(bl, last)));
+            i = mask ? check_block(i, 16, mask, needle, res, cursor) : i + 16;
+        }
+        return i;
+    }
+#endif
+
+    std::string arena;                                  //!< 以 `'\0'` 分隔的全部字符串
+    std::vector<uint32_t> offsets;                      //!< 第 i 个字符串起始于 `offsets[i]`，末项为存储区长度
+    std::unordered_map<std::string_view, uint32_t> ids; //!< 指向 `arena` 的视图 -> ID
+};
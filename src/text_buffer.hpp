@@ -0,0 +1,165 @@
+/**
+ * @file text_buffer.hpp
+ * @author Nq139 (fnq409997@gmail.com)
+ * @brief 可复用的命令输出缓冲区及其分页输出
+ * @copyright Copyright 2026, Nq139
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <charconv>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+/**
+ * @brief 命令输出缓冲区
+ * @note 命令在持锁期间仅向缓冲区追加文本，释放锁后再以一次 `write` 输出，终端的快慢不会影响收包线程；
+ *       `clear()` 保留已分配的容量，同一缓冲区在命令之间复用
+ */
+class TextBuffer
+{
+public:
+    //! 清空内容，保留容量
+    void clear() { buf.clear(); }
+
+    //! 已缓冲的文本
+    std::string_view view() const { return buf; }
+
+    //! 追加字符串
+    TextBuffer &put(std::string_view s)
+    {
+        buf.append(s);
+        return *this;
+    }
+
+    //! 追加单个字符
+    TextBuffer &put(char c)
+    {
+        buf.push_back(c);
+        return *this;
+    }
+
+    //! 追加字符串，不足 `width` 时以空格右补齐，等价于 `%-*s`
+    TextBuffer &pad(std::string_view s, size_t width)
+    {
+        buf.append(s);
+        if (s.size() < width)
+            buf.append(width - s.size(), ' ');
+        return *this;
+    }
+
+    //! 追加十进制整数
+    TextBuffer &num(uint64_t v) { return integer(v, 10); }
+
+    //! 追加十六进制整数，等价于 `%lx`
+    TextBuffer &hex(uint64_t v) { return integer(v, 16); }
+
+    //! 追加定点小数，等价于 `%.*f`
+    TextBuffer &fixed(double v, int prec)
+    {
+        char tmp[64];
+        auto res = std::to_chars(tmp, tmp + sizeof(tmp), v, std::chars_format::fixed, prec);
+        if (res.ec != std::errc())
+            return format("%.*f", prec, v);
+        buf.append(tmp, res.ptr);
+        return *this;
+    }
+
+    //! 以 `printf` 格式追加，用于不在热点上的输出
+    __attribute__((format(printf, 2, 3))) TextBuffer &format(const char *fmt, ...)
+    {
+        va_list ap, ap2;
+        va_start(ap, fmt);
+        va_copy(ap2, ap);
+        size_t old = buf.size();
+        buf.resize(old + 128);
+        int n = vsnprintf(&buf[old], 129, fmt, ap);
+        if (n > 128)
+        {
+            buf.resize(old + n);
+            vsnprintf(&buf[old], n + 1, fmt, ap2);
+        }
+        buf.resize(old + (n > 0 ? n : 0));
+        va_end(ap2);
+        va_end(ap);
+        return *this;
+    }
+
+    /**
+     * @brief 输出缓冲区内容并清空
+     * @param[in] paged 标准输入输出均为终端且内容超过一屏时，是否逐屏输出并等待按键
+     */
+    void flush(bool paged = true)
+    {
+        fflush(stdout);
+        std::string_view rest = buf;
+        size_t rows = paged && isatty(STDIN_FILENO) && isatty(STDOUT_FILENO) ? terminal_rows() : 0;
+        while (rows > 1 && !rest.empty())
+        {
+            // 定位一屏（留出一行提示）的末尾
+            size_t end = 0, lines = 0;
+            while (end < rest.size() && lines < rows - 1)
+            {
+                auto nl = rest.find('\n', end);
+                end = nl == std::string_view::npos ? rest.size() : nl + 1;
+                lines++;
+            }
+            if (end == rest.size())
+                break;
+            write_all(rest.substr(0, end));
+            rest.remove_prefix(end);
+            write_all("-- More -- (Enter: next page, q: quit) ");
+            char line[64];
+            if (!fgets(line, sizeof(line), stdin) || line[0] == 'q')
+            {
+                rest = {};
+                break;
+            }
+        }
+        write_all(rest);
+        buf.clear();
+    }
+
+private:
+    TextBuffer &integer(uint64_t v, int base)
+    {
+        char tmp[24];
+        auto res = std::to_chars(tmp, tmp + sizeof(tmp), v, base);
+        buf.append(tmp, res.ptr);
+        return *this;
+    }
+
+    //! 终端行数，无法获取时按 `LINES` 环境变量或 24 行处理
+    static size_t terminal_rows()
+    {
+        winsize ws{};
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0)
+            return ws.ws_row;
+        const char *env = getenv("LINES");
+        return env && atoi(env) > 0 ? atoi(env) : 24;
+    }
+
+    //! 写出全部内容，处理部分写入与信号中断
+    static void write_all(std::string_view s)
+    {
+        while (!s.empty())
+        {
+            ssize_t n = ::write(STDOUT_FILENO, s.data(), s.size());
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return;
+            s.remove_prefix(n);
+        }
+    }
+
+    std::string buf;
+};
@@ -0,0 +1,356 @@
+/**
+ * @file thread_placement.hpp
+ * @author Nq139 (fnq409997@gmail.com)
+ * @brief 按线程类别配置 CPU 亲和性、调度策略与 nice 值
+ * @copyright Copyright 2026, Nq139
+ */
+
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @brief 线程放置配置
+ * @details 各线程启动时以 `enter()` 声明所属类别，按该类别的配置设置自身的亲和性、调度策略与 nice 值，并登记以便在
+ *          `stats` 中报告实际生效的放置。未配置的类别保持从创建者继承的设置。配置语法
+ *          `<class>:<key>=<value>[,<key>=<value>]...`，`class` 为 `receive`、`heartbeat`、`exporter`、`render` 或 `all`，
+ *          `key` 为
+ * - `cpus`：CPU 列表，如 `0-1,4`
+ * - `policy`：`other`、`batch`、`idle`、`fifo` 或 `rr`
+ * - `prio`：`fifo`/`rr` 的实时优先级
+ * - `nice`：nice 值，对 `other`/`batch` 有效
+ */
+class ThreadPlacement
+{
+public:
+    //! 线程类别
+    enum Class : uint8_t
+    {
+        Receive,   //!< 收包与解析线程
+        Heartbeat, //!< 心跳与超时清理线程
+        Exporter,  //!< 告警等输出线程
+        Render,    //!< 命令行交互与输出生成线程
+        CLASSES,
+    };
+
+    static constexpr const char *CLASS_NAMES[CLASSES] = {"receive", "heartbeat", "exporter", "render"};
+
+    //! 单个类别的配置
+    struct Config
+    {
+        std::vector<int> cpus; //!< 允许运行的 CPU，空表示不修改
+        int policy{-1};        //!< 调度策略，`-1` 表示不修改
+        int priority{};        //!< 实时优先级
+        bool has_nice{};       //!< 是否设置 nice 值
+        int nice{};            //!< nice 值
+    };
+
+    //! 已登记线程的实际放置
+    struct ThreadInfo
+    {
+        std::string name;
+        Class cls;
+        pid_t tid;
+        std::vector<int> cpus; //!< 实际允许运行的 CPU
+        int current_cpu;       //!< 最近一次运行所在的 CPU
+        int policy;
+        int priority;
+        int nice;
+        std::string error; //!< 应用配置时的错误
+    };
+
+    //! 全局配置
+    static ThreadPlacement &global()
+    {
+        static ThreadPlacement placement;
+        return placement;
+    }
+
+    /**
+     * @brief 解析并保存一条配置
+     * @param[in] spec 配置文本
+     * @param[out] err 错误描述
+     * @return 是否解析成功
+     */
+    bool configure(const std::string &spec, std::string &err)
+    {
+        auto colon = spec.find(':');
+        std::string cls = spec.substr(0, colon);
+        int idx = cls == "all" ? CLASSES : -1;
+        for (int i = 0; i < CLASSES; i++)
+            if (cls == CLASS_NAMES[i])
+                idx = i;
+        if (idx < 0 || colon == std::string::npos)
+            return err = "unknown thread class '" + cls + "'", false;
+        Config cfg = idx == CLASSES ? Config{} : configs[idx];
+        size_t pos = colon + 1;
+        while (pos < spec.size())
+        {
+            size_t end = spec.find(',', pos), eq = spec.find('=', pos);
+            // `cpus` 的值本身含逗号，延伸到下一个 `key=` 之前
+            if (!spec.compare(pos, 5, "cpus="))
+            {
+                end = spec.find('=', eq + 1);
+                end = end == std::string::npos ? spec.size() : spec.rfind(',', end);
+            }
+            end = end == std::string::npos ? spec.size() : end;
+            if (eq == std::string::npos || eq > end)
+                return err = "expected <key>=<value>", false;
+            std::string key = spec.substr(pos, eq - pos), value = spec.substr(eq + 1, end - eq - 1);
+            if (key == "cpus" && !parse_cpus(value, cfg.cpus))
+                return err = "invalid cpu list '" + value + "'", false;
+            else if (key == "policy" && (cfg.policy = parse_policy(value)) < 0)
+                return err = "unknown policy '" + value + "'", false;
+            else if (key == "prio")
+                cfg.priority = atoi(value.c_str());
+            else if (key == "nice")
+                cfg.has_nice = true, cfg.nice = atoi(value.c_str());
+            else if (key != "cpus" && key != "policy")
+                return err = "unknown key '" + key + "'", false;
+            pos = end + 1;
+        }
+        if (cfg.policy == SCHED_FIFO || cfg.policy == SCHED_RR)
+        {
+            if (cfg.priority < sched_get_priority_min(cfg.policy) || cfg.priority > sched_get_priority_max(cfg.policy))
+                return err = "prio out of range for " + std::string(policy_name(cfg.policy)), false;
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        for (int i = 0; i < CLASSES; i++)
+            if (idx == CLASSES || idx == i)
+                configs[i] = cfg;
+        return true;
+    }
+
+    //! 线程在放置表中的登记，析构时注销
+    class Scope
+    {
+    public:
+        explicit Scope(size_t id) : id(id) {}
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+        ~Scope() { global().leave(id); }
+
+    private:
+        size_t id;
+    };
+
+    /**
+     * @brief 对当前线程应用所属类别的配置并登记
+     * @param[in] cls 线程类别
+     * @param[in] name 线程名，主线程之外同时设置为系统线程名（最长 15 字符）
+     * @return 登记对象，线程退出前保持存活
+     */
+    Scope enter(Class cls, const char *name)
+    {
+        pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+        if (tid != getpid())
+            pthread_setname_np(pthread_self(), std::string(name).substr(0, 15).c_str());
+        Config cfg;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            cfg = configs[cls];
+        }
+        Entry e{name, cls, tid, pthread_self(), {}};
+        auto fail = [&](const char *what, int code) {
+            e.error += std::string(e.error.empty() ? "" : ", ") + what + ": " + strerror(code);
+        };
+        if (!cfg.cpus.empty())
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : cfg.cpus)
+                CPU_SET(cpu, &set);
+            if (int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+                fail("cpus", rc);
+        }
+        if (cfg.policy >= 0)
+        {
+            sched_param param{};
+            param.sched_priority = cfg.policy == SCHED_FIFO || cfg.policy == SCHED_RR ? cfg.priority : 0;
+            if (int rc = pthread_setschedparam(pthread_self(), cfg.policy, &param))
+                fail("policy", rc);
+        }
+        // Linux 上 nice 值按线程生效
+        if (cfg.has_nice && setpriority(PRIO_PROCESS, e.tid, cfg.nice) != 0)
+            fail("nice", errno);
+
+        std::lock_guard<std::mutex> lock(mtx);
+        e.id = next_id++;
+        entries.push_back(std::move(e));
+        return Scope(entries.back().id);
+    }
+
+    //! 读取各已登记线程当前实际生效的放置
+    std::vector<ThreadInfo> snapshot()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::vector<ThreadInfo> res;
+        for (auto &e : entries)
+        {
+            ThreadInfo info{e.name, e.cls, e.tid, {}, -1, -1, 0, 0, e.error};
+            cpu_set_t set;
+            if (pthread_getaffinity_np(e.handle, sizeof(set), &set) == 0)
+                for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+                    if (CPU_ISSET(cpu, &set))
+                        info.cpus.push_back(cpu);
+            sched_param param{};
+            if (pthread_getschedparam(e.handle, &info.policy, &param) == 0)
+                info.priority = param.sched_priority;
+            info.nice = getpriority(PRIO_PROCESS, e.tid);
+            info.current_cpu = current_cpu(e.tid);
+            res.push_back(std::move(info));
+        }
+        return res;
+    }
+
+    //! 各类别线程累计消耗的 CPU 时间（纳秒），包括已退出的线程
+    std::array<uint64_t, CLASSES> cpu_time()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto res = retired_ns;
+        for (auto &e : entries)
+        {
+            clockid_t cid;
+            timespec ts{};
+            if (pthread_getcpuclockid(e.handle, &cid) == 0 && clock_gettime(cid, &ts) == 0)
+                res[e.cls] += ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+        }
+        return res;
+    }
+
+    //! 调度策略名
+    static const char *policy_name(int policy)
+    {
+        switch (policy)
+        {
+        case SCHED_OTHER:
+            return "other";
+        case SCHED_BATCH:
+            return "batch";
+        case SCHED_IDLE:
+            return "idle";
+        case SCHED_FIFO:
+            return "fifo";
+        case SCHED_RR:
+            return "rr";
+        default:
+            return "?";
+        }
+    }
+
+    //! 将 CPU 编号格式化为 `0-3,6` 形式的列表
+    static std::string cpu_list(const std::vector<int> &cpus)
+    {
+        std::string res;
+        for (size_t i = 0; i < cpus.size();)
+        {
+            size_t j = i;
+            while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1)
+                j++;
+            res += (res.empty() ? "" : ",") + std::to_string(cpus[i]);
+            if (j > i)
+                res += "-" + std::to_string(cpus[j]);
+            i = j + 1;
+        }
+        return res;
+    }
+
+private:
+    struct Entry
+    {
+        std::string name;
+        Class cls;
+        pid_t tid;
+        pthread_t handle;
+        std::string error;
+        size_t id{};
+    };
+
+    //! 由线程自身在退出前调用，其 CPU 时间并入所属类别的累计值
+    void leave(size_t id)
+    {
+        timespec ts{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto it = entries.begin(); it != entries.end(); ++it)
+            if (it->id == id)
+            {
+                retired_ns[it->cls] += ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+                entries.erase(it);
+                return;
+            }
+    }
+
+    static int parse_policy(const std::string &s)
+    {
+        for (int policy : {SCHED_OTHER, SCHED_BATCH, SCHED_IDLE, SCHED_FIFO, SCHED_RR})
+            if (s == policy_name(policy))
+                return policy;
+        return -1;
+    }
+
+    static bool parse_cpus(const std::string &s, std::vector<int> &cpus)
+    {
+        cpus.clear();
+        const char *p = s.c_str();
+        while (*p)
+        {
+            char *end;
+            long lo = strtol(p, &end, 10), hi = lo;
+            if (end == p)
+                return false;
+            if (*end == '-')
+            {
+                p = end + 1;
+                hi = strtol(p, &end, 10);
+                if (end == p)
+                    return false;
+            }
+            if (lo < 0 || hi < lo || hi >= CPU_SETSIZE)
+                return false;
+            for (long cpu = lo; cpu <= hi; cpu++)
+                cpus.push_back(static_cast<int>(cpu));
+            if (*end && *end != ',')
+                return false;
+            p = *end ? end + 1 : end;
+        }
+        return !cpus.empty();
+    }
+
+    //! 线程最近一次运行所在的 CPU，取自 `/proc/self/task/<tid>/stat` 的第 39 个字段
+    static int current_cpu(pid_t tid)
+    {
+        char path[64], buf[1024];
+        snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+        FILE *fp = fopen(path, "r");
+        if (!fp)
+            return -1;
+        size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+        fclose(fp);
+        buf[n] = '\0';
+        // 线程名可能含空格，从右括号之后开始计数（其后为第 3 个字段）
+        const char *p = strrchr(buf, ')');
+        for (int field = 2; p && field < 39; field++)
+            p = strchr(p + 1, ' ');
+        return p ? atoi(p + 1) : -1;
+    }
+
+    std::mutex mtx;
+    Config configs[CLASSES];
+    std::vector<Entry> entries;
+    size_t next_id{};
+    std::array<uint64_t, CLASSES> retired_ns{}; //!< 已退出线程的 CPU 时间
+};
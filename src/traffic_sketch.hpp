@@ -0,0 +1,360 @@
+/**
+ * @file traffic_sketch.hpp
+ * @author Nq139 (fnq409997@gmail.com)
+ * @brief 固定内存、可合并的流量概率摘要
+ * @copyright Copyright 2026, Nq139
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//! 64 位整数混淆（splitmix64 的终结步骤）
+inline uint64_t mix64(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+//! 字符串的 64 位哈希（FNV-1a 后再混淆）
+inline uint64_t hash64(std::string_view s)
+{
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (unsigned char c : s)
+        h = (h ^ c) * 0x100000001B3ULL;
+    return mix64(h);
+}
+
+/**
+ * @brief Count-Min 草图
+ * @details 估计值不小于真实值，且以至少 `1 - e^-D` 的概率不超过真实值 `+ (e / W) * N`，`N` 为全部计数之和
+ * @tparam W 每行的计数器数，须为 2 的幂
+ * @tparam D 行数
+ */
+template <size_t W, size_t D>
+class CountMinSketch
+{
+    static_assert((W & (W - 1)) == 0, "width must be a power of two");
+
+public:
+    //! 键 `key` 的计数增加 `n`
+    void add(uint64_t key, uint64_t n)
+    {
+        total += n;
+        for (size_t d = 0; d < D; d++)
+            rows[d][index(key, d)] += n;
+    }
+
+    //! 键 `key` 的计数估计
+    uint64_t estimate(uint64_t key) const
+    {
+        uint64_t res = UINT64_MAX;
+        for (size_t d = 0; d < D; d++)
+            res = std::min(res, rows[d][index(key, d)]);
+        return res;
+    }
+
+    //! 并入另一草图，结果等同于对两者的输入一并计数
+    void merge(const CountMinSketch &other)
+    {
+        total += other.total;
+        for (size_t d = 0; d < D; d++)
+            for (size_t w = 0; w < W; w++)
+                rows[d][w] += other.rows[d][w];
+    }
+
+    //! 全部计数之和
+    uint64_t sum() const { return total; }
+    //! 相对于 `sum()` 的误差上界
+    static double epsilon() { return std::exp(1.0) / W; }
+    //! 估计超出误差上界的概率
+    static double delta() { return std::exp(-static_cast<double>(D)); }
+
+private:
+    static size_t index(uint64_t key, size_t d) { return mix64(key + 0x9E3779B97F4A7C15ULL * (d + 1)) & (W - 1); }
+
+    std::array<std::array<uint64_t, W>, D> rows{};
+    uint64_t total{};
+};
+
+/**
+ * @brief HyperLogLog 基数估计
+ * @details 标准误差约为 `1.04 / sqrt(2^P)`，小基数时改用线性计数
+ * @tparam P 寄存器数的以 2 为底的对数
+ */
+template <unsigned P>
+class HyperLogLog
+{
+    static_assert(P >= 4 && P <= 16, "precision out of range");
+    static constexpr size_t M = size_t(1) << P;
+
+public:
+    //! 加入一个已混淆的 64 位哈希
+    void add(uint64_t hash)
+    {
+        size_t idx = hash >> (64 - P);
+        uint64_t rest = hash << P;
+        uint8_t rank = rest ? static_cast<uint8_t>(__builtin_clzll(rest) + 1) : static_cast<uint8_t>(64 - P + 1);
+        regs[idx] = std::max(regs[idx], rank);
+    }
+
+    //! 基数估计
+    double estimate() const
+    {
+        double alpha = M == 16 ? 0.673 : M == 32 ? 0.697 : M == 64 ? 0.709 : 0.7213 / (1 + 1.079 / M);
+        double sum = 0;
+        size_t zeros = 0;
+        for (uint8_t r : regs)
+        {
+            sum += std::ldexp(1.0, -r);
+            zeros += r == 0;
+        }
+        double e = alpha * M * M / sum;
+        if (e <= 2.5 * M && zeros)
+            e = M * std::log(static_cast<double>(M) / zeros);
+        return e;
+    }
+
+    //! 并入另一估计器，结果等同于对两者的输入求并集
+    void merge(const HyperLogLog &other)
+    {
+        for (size_t i = 0; i < M; i++)
+            regs[i] = std::max(regs[i], other.regs[i]);
+    }
+
+    void clear() { regs.fill(0); }
+
+    //! 相对标准误差
+    static double error() { return 1.04 / std::sqrt(static_cast<double>(M)); }
+
+private:
+    std::array<uint8_t, M> regs{};
+};
+
+/**
+ * @brief Space-Saving 重流量检测
+ * @details 固定保留 `K` 个计数器，新键替换计数最小者并继承其计数作为误差。每个条目的计数不小于真实值，超出部分不超过
+ *          其 `error`，也不超过 `N / K`；真实计数超过 `N / K` 的键必然在表中。每个条目可附带一个随条目替换而重置的
+ *          数据 `Extra`，它只反映条目进入表之后的输入
+ * @tparam K 计数器数
+ * @tparam Extra 条目附带的数据，须提供 `clear()` 与 `merge()`
+ */
+template <size_t K, typename Extra>
+class SpaceSaving
+{
+public:
+    //! 名称的最大保留长度，超出部分截断以使内存固定
+    static constexpr size_t LABEL_MAX = 63;
+
+    struct Entry
+    {
+        uint64_t key{};                       //!< 键的哈希
+        uint64_t count{};                     //!< 计数上界
+        uint64_t error{};                     //!< 计数可能高估的上界
+        uint8_t len{};                        //!< 名称长度
+        std::array<char, LABEL_MAX> label{};  //!< 名称
+        Extra extra{};                        //!< 附带数据
+
+        std::string_view name() const { return {label.data(), len}; }
+    };
+
+    /**
+     * @brief 键的计数增加 `n`
+     * @param[in] key 键的哈希
+     * @param[in] label 键的名称
+     * @param[in] n 增量
+     * @return 键所在的条目
+     */
+    Entry &add(uint64_t key, std::string_view label, uint64_t n)
+    {
+        total += n;
+        Entry *min = nullptr;
+        for (size_t i = 0; i < used; i++)
+        {
+            if (table[i].key == key)
+                return table[i].count += n, table[i];
+            if (!min || table[i].count < min->count)
+                min = &table[i];
+        }
+        Entry &e = used < K ? table[used++] : *min;
+        e.error = &e == min ? e.count : 0;
+        e.count = e.error + n;
+        e.key = key;
+        e.len = static_cast<uint8_t>(std::min(label.size(), LABEL_MAX));
+        std::copy_n(label.data(), e.len, e.label.data());
+        e.extra.clear();
+        return e;
+    }
+
+    /**
+     * @brief 并入另一摘要
+     * @details 一方缺少的键以该方的最小计数作为可能遗漏的计数，同时计入计数与误差，合并后保留计数最大的 `K` 个条目，
+     *          误差上界 `N / K` 仍然成立
+     */
+    void merge(const SpaceSaving &other)
+    {
+        uint64_t min_a = used == K ? min_count() : 0, min_b = other.used == K ? other.min_count() : 0;
+        std::vector<Entry> all(table.begin(), table.begin() + used);
+        for (auto &e : all)
+            e.count += min_b, e.error += min_b;
+        for (size_t i = 0; i < other.used; i++)
+        {
+            auto &o = other.table[i];
+            auto it = std::find_if(all.begin(), all.end(), [&](const Entry &e) { return e.key == o.key; });
+            if (it != all.end())
+            {
+                it->count += o.count - min_b;
+                it->error += o.error - min_b;
+                it->extra.merge(o.extra);
+            }
+            else
+            {
+                all.push_back(o);
+                all.back().count += min_a;
+                all.back().error += min_a;
+            }
+        }
+        std::sort(all.begin(), all.end(), [](const Entry &a, const Entry &b) { return a.count > b.count; });
+        used = std::min(all.size(), K);
+        std::copy_n(all.begin(), used, table.begin());
+        total += other.total;
+    }
+
+    //! 按计数降序排列的条目
+    std::vector<const Entry *> top() const
+    {
+        std::vector<const Entry *> res;
+        for (size_t i = 0; i < used; i++)
+            res.push_back(&table[i]);
+        std::sort(res.begin(), res.end(), [](const Entry *a, const Entry *b) { return a->count > b->count; });
+        return res;
+    }
+
+    //! 全部计数之和
+    uint64_t sum() const { return total; }
+    //! 计数高估的全局上界
+    uint64_t error_bound() const { return total / K; }
+
+private:
+    uint64_t min_count() const
+    {
+        uint64_t res = UINT64_MAX;
+        for (size_t i = 0; i < used; i++)
+            res = std::min(res, table[i].count);
+        return res;
+    }
+
+    std::array<Entry, K> table{};
+    size_t used{};
+    uint64_t total{};
+};
+
+//! 不附带数据的条目
+struct NoExtra
+{
+    void clear() {}
+    void merge(const NoExtra &) {}
+};
+
+/**
+ * @brief 一个收包线程的流量摘要
+ * @details 来源以发送方 IPv4 地址与端口标识，话题取自 REDP 报文，其余报文的话题为空。全部结构的大小在编译期确定，
+ *          与流量中来源和话题的多少无关
+ */
+struct TrafficSketch
+{
+    static constexpr size_t TOP_K = 32; //!< 重流量来源与话题的跟踪数
+
+    CountMinSketch<1024, 4> bytes;                //!< (来源, 话题) -> 字节数
+    HyperLogLog<12> senders;                      //!< 全部来源的去重计数
+    SpaceSaving<TOP_K, NoExtra> top_sources;      //!< 字节数最多的来源
+    SpaceSaving<TOP_K, HyperLogLog<8>> top_topics; //!< 字节数最多的话题，附带各话题的来源去重计数
+
+    //! 来源键
+    static uint64_t source_key(uint32_t addr, uint16_t port) { return (static_cast<uint64_t>(addr) << 16) | port; }
+
+    //! (来源, 话题) 键
+    static uint64_t flow_key(uint64_t source, std::string_view topic) { return mix64(source) ^ hash64(topic); }
+
+    /**
+     * @brief 记录一个数据报
+     * @param[in] source 来源键
+     * @param[in] source_label 来源名称，如 `10.0.0.2:7500`
+     * @param[in] topic 话题名，无话题时为空
+     * @param[in] n 字节数
+     */
+    void add(uint64_t source, std::string_view source_label, std::string_view topic, uint64_t n)
+    {
+        uint64_t h = mix64(source);
+        bytes.add(flow_key(source, topic), n);
+        senders.add(h);
+        top_sources.add(h, source_label, n);
+        if (!topic.empty())
+            top_topics.add(hash64(topic), topic, n).extra.add(h);
+    }
+
+    void merge(const TrafficSketch &other)
+    {
+        bytes.merge(other.bytes);
+        senders.merge(other.senders);
+        top_sources.merge(other.top_sources);
+        top_topics.merge(other.top_topics);
+    }
+};
+
+/**
+ * @brief 各收包线程的流量摘要
+ * @details 每个收包线程独占一个分片，写入时只锁本分片，无跨线程竞争；读取时逐个分片加锁复制并合并
+ */
+class TrafficStats
+{
+public:
+    struct Shard
+    {
+        std::mutex mtx;
+        TrafficSketch sketch;
+    };
+
+    //! 为调用线程分配一个分片，分片在对象析构前一直有效
+    Shard &attach()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        shards.push_back(std::make_unique<Shard>());
+        return *shards.back();
+    }
+
+    //! 合并全部分片
+    std::unique_ptr<TrafficSketch> merged()
+    {
+        auto res = std::make_unique<TrafficSketch>();
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto &shard : shards)
+        {
+            std::lock_guard<std::mutex> shard_lock(shard->mtx);
+            res->merge(shard->sketch);
+        }
+        return res;
+    }
+
+    //! 分片数
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return shards.size();
+    }
+
+private:
+    std::mutex mtx;
+    std::vector<std::unique_ptr<Shard>> shards;
+};
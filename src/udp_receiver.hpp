@@ -0,0 +1,152 @@
+/**
+ * @file udp_receiver.hpp
+ * @author Nq139 (fnq409997@gmail.com)
+ * @brief 携带内核接收时间戳的 UDP 接收端
+ * @copyright Copyright 2026, Nq139
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+//! 一个已接收的数据报
+struct Datagram
+{
+    std::string_view data;                           //!< 报文内容，指向接收端的缓冲区，下次接收前有效
+    uint32_t addr{};                                 //!< 发送方 IPv4 地址（网络字节序）
+    uint16_t port{};                                 //!< 发送方端口
+    uint32_t dst_addr{};                             //!< 目的 IPv4 地址（网络字节序），仅被动抓包时填写
+    uint16_t dst_port{};                             //!< 目的端口，仅被动抓包时填写
+    bool kernel_ts{};                                //!< 是否取得内核接收时间戳
+    std::chrono::steady_clock::time_point arrival;   //!< 到达时刻，取自内核时间戳并换算到单调时钟
+    std::chrono::nanoseconds sched_delay{};          //!< 内核收包至用户态取得报文之间的调度延迟
+};
+
+/**
+ * @brief 启用 `SO_TIMESTAMPNS` 的 UDP 接收端
+ * @note 内核时间戳基于 `CLOCK_REALTIME`，接收后立即以实时时钟求出调度延迟，再从单调时钟的当前时刻中扣除得到到达时刻，
+ *       因此到达时刻不受系统时间跳变影响；未能取得时间戳时到达时刻即为用户态接收时刻
+ */
+class UdpReceiver
+{
+public:
+    /**
+     * @brief 创建并绑定接收端
+     * @param[in] port 本地端口，`0` 表示由系统分配
+     * @param[in] group 加入的组播地址，空表示不加入
+     * @param[in] timeout 接收超时，使接收线程能周期性检查退出标志
+     */
+    UdpReceiver(uint16_t port, std::string_view group = {}, std::chrono::milliseconds timeout = std::chrono::milliseconds(500))
+    {
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0)
+            return;
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        timestamps = setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) == 0;
+        timeval tv{static_cast<time_t>(timeout.count() / 1000), static_cast<suseconds_t>(timeout.count() % 1000 * 1000)};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(port);
+        if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+        {
+            close(fd), fd = -1;
+            return;
+        }
+        if (!group.empty())
+        {
+            ip_mreq mreq{};
+            inet_pton(AF_INET, std::string(group).c_str(), &mreq.imr_multiaddr);
+            mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+            setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq));
+        }
+    }
+
+    UdpReceiver(UdpReceiver &&other) noexcept : fd(other.fd), timestamps(other.timestamps) { other.fd = -1; }
+    UdpReceiver(const UdpReceiver &) = delete;
+    UdpReceiver &operator=(const UdpReceiver &) = delete;
+    ~UdpReceiver()
+    {
+        if (fd >= 0)
+            close(fd);
+    }
+
+    //! 是否创建并绑定成功
+    bool valid() const { return fd >= 0; }
+
+    //! 内核是否接受了 `SO_TIMESTAMPNS`
+    bool has_timestamps() const { return timestamps; }
+
+    //! 绑定的本地端口
+    uint16_t port() const
+    {
+        sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+        getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len);
+        return ntohs(addr.sin_port);
+    }
+
+    /**
+     * @brief 接收一个数据报
+     * @param[out] d 接收结果
+     * @return 是否收到数据报，超时或出错时返回 `false`
+     */
+    bool recv(Datagram &d)
+    {
+        sockaddr_in from{};
+        iovec iov{buf, sizeof(buf) - 1};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(timespec))];
+        msghdr msg{};
+        msg.msg_name = &from;
+        msg.msg_namelen = sizeof(from);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        ssize_t n = recvmsg(fd, &msg, 0);
+        if (n < 0)
+            return false;
+        auto steady_now = std::chrono::steady_clock::now();
+        timespec real_now;
+        clock_gettime(CLOCK_REALTIME, &real_now);
+
+        buf[n] = '\0'; // 与以 std::string 接收时一致，报文之后总有结尾的 '\0'
+        d.data = std::string_view(buf, n);
+        d.addr = from.sin_addr.s_addr;
+        d.port = ntohs(from.sin_port);
+        d.kernel_ts = false;
+        d.sched_delay = {};
+        for (cmsghdr *c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c))
+        {
+            if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS)
+            {
+                timespec ts;
+                memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+                auto delay = std::chrono::seconds(real_now.tv_sec - ts.tv_sec) + std::chrono::nanoseconds(real_now.tv_nsec - ts.tv_nsec);
+                // 实时时钟被向后调整时延迟可能为负，此时视为无延迟
+                d.sched_delay = std::max(delay, std::chrono::nanoseconds::zero());
+                d.kernel_ts = true;
+            }
+        }
+        d.arrival = steady_now - d.sched_delay;
+        return true;
+    }
+
+private:
+    int fd{-1};
+    bool timestamps{};
+    char buf[65536];
+};
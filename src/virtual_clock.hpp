@@ -0,0 +1,155 @@
+/**
+ * @file virtual_clock.hpp
+ * @author Nq139 (fnq409997@gmail.com)
+ * @brief 可切换为虚拟时间的单调时钟
+ * @copyright Copyright 2026, Nq139
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+#include <set>
+#include <thread>
+
+/**
+ * @brief 检查器的时钟
+ * @details 默认即 `std::chrono::steady_clock`。调用 `use_virtual()` 后，`now()` 返回只由 `advance()` 推进的虚拟时间，
+ *          以 `sleep_until()` 等待的线程也只在虚拟时间到达时被唤醒，超时、抖动抑制、历史采样等定时逻辑因而可以在
+ *          毫秒级的真实时间内跑完数小时的虚拟时间，且结果确定。时间点类型与 `steady_clock` 相同，二者的时间点可直接比较
+ * @note 测量真实耗时（锁等待、清理耗时、CPU 占用等）应直接使用 `steady_clock`，不受虚拟时间影响
+ */
+class Clock
+{
+public:
+    using duration = std::chrono::steady_clock::duration;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::steady_clock::time_point;
+    static constexpr bool is_steady = true;
+
+    //! 当前时间
+    static time_point now()
+    {
+        if (!virtual_mode.load(std::memory_order_acquire))
+            return std::chrono::steady_clock::now();
+        return time_point(duration(virtual_now.load(std::memory_order_acquire)));
+    }
+
+    //! 是否处于虚拟时间模式
+    static bool is_virtual() { return virtual_mode.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 切换为虚拟时间
+     * @note 须在任何线程读取时钟之前调用，且不可切换回真实时间
+     * @param[in] start 虚拟时间的起点，默认避开表示“未设置”的零值
+     */
+    static void use_virtual(time_point start = time_point(std::chrono::hours(1)))
+    {
+        virtual_now.store(start.time_since_epoch().count(), std::memory_order_release);
+        virtual_mode.store(true, std::memory_order_release);
+    }
+
+    /**
+     * @brief 推进虚拟时间
+     * @details 依次跳到区间内各等待线程的唤醒时刻，每跳一次都等被唤醒的线程处理完并重新进入等待（或调用 `idle()`）
+     *          后再继续，因此推进 1 h 时每秒一次的定时任务恰好执行 3600 次，与推进的粒度无关
+     * @note 调用期间不得持有被唤醒线程需要的锁
+     * @param[in] d 推进的时长
+     */
+    static void advance(duration d)
+    {
+        auto &s = shared();
+        std::unique_lock<std::mutex> lock(s.mtx);
+        auto target = now() + d;
+        for (bool done = false; !done;)
+        {
+            auto next = s.deadlines.empty() || *s.deadlines.begin() > target ? target : *s.deadlines.begin();
+            done = next == target;
+            virtual_now.store(next.time_since_epoch().count(), std::memory_order_release);
+            s.busy += std::distance(s.deadlines.begin(), s.deadlines.upper_bound(next));
+            s.cv.notify_all();
+            s.cv.wait(lock, [&] { return s.busy == 0; });
+        }
+    }
+
+    /**
+     * @brief 等待至时刻 `t` 或 `running` 被清除
+     * @details 真实时间模式下即 `std::this_thread::sleep_until()`；虚拟时间模式下每 100 ms（真实时间）检查一次
+     *          `running`，以便停止时及时退出
+     */
+    static void sleep_until(time_point t, const std::atomic<bool> &running)
+    {
+        if (!is_virtual())
+        {
+            std::this_thread::sleep_until(t);
+            return;
+        }
+        auto &s = shared();
+        std::unique_lock<std::mutex> lock(s.mtx);
+        release(s);
+        auto it = s.deadlines.insert(t);
+        while (running && now() < t)
+            s.cv.wait_for(lock, std::chrono::milliseconds(100));
+        s.deadlines.erase(it);
+        woken = now() >= t;
+    }
+
+    /**
+     * @brief 声明即将启动一个定时线程，此后 `advance()` 先等它首次进入等待再推进时间
+     * @note 在启动线程之前调用，线程开始后须先调用 `enter()`
+     */
+    static void enroll()
+    {
+        if (!is_virtual())
+            return;
+        auto &s = shared();
+        std::lock_guard<std::mutex> lock(s.mtx);
+        s.busy++;
+    }
+
+    //! 由 `enroll()` 声明的定时线程开始时调用
+    static void enter() { woken = is_virtual(); }
+
+    //! 声明调用线程已处理完被唤醒后的工作且不再等待，定时线程退出前调用
+    static void idle()
+    {
+        if (!is_virtual())
+            return;
+        auto &s = shared();
+        std::lock_guard<std::mutex> lock(s.mtx);
+        release(s);
+    }
+
+private:
+    struct Shared
+    {
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::multiset<time_point> deadlines; //!< 各等待线程的唤醒时刻
+        size_t busy{};                       //!< 已被唤醒或刚启动、尚未进入等待的线程数
+    };
+
+    static Shared &shared()
+    {
+        static Shared s;
+        return s;
+    }
+
+    //! 调用线程若计入了忙碌计数则将其移除，调用方需持有 `s.mtx`
+    static void release(Shared &s)
+    {
+        if (!woken)
+            return;
+        woken = false;
+        s.busy--;
+        s.cv.notify_all();
+    }
+
+    static inline std::atomic<bool> virtual_mode{};
+    static inline std::atomic<rep> virtual_now{};
+    static inline thread_local bool woken{}; //!< 调用线程是否计入了忙碌计数
+};
@@ -0,0 +1,673 @@
+/**
+ * @file web_ui.hpp
+ * @author Nq139 (fnq409997@gmail.com)
+ * @brief 本地网页拓扑视图，以 WebSocket 推送增量
+ * @copyright Copyright 2026, Nq139
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "inspector.hpp"
+#include "metrics.hpp"
+#include "thread_placement.hpp"
+
+//! SHA-1 摘要，仅用于 WebSocket 握手
+inline std::array<uint8_t, 20> sha1(std::string_view data)
+{
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    std::string msg(data);
+    uint64_t bits = static_cast<uint64_t>(data.size()) * 8;
+    msg += '\x80';
+    while (msg.size() % 64 != 56)
+        msg += '\0';
+    for (int i = 7; i >= 0; i--)
+        msg += static_cast<char>(bits >> (i * 8));
+    auto rol = [](uint32_t x, int n) { return (x << n) | (x >> (32 - n)); };
+    for (size_t off = 0; off < msg.size(); off += 64)
+    {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++)
+            w[i] = static_cast<uint32_t>(static_cast<uint8_t>(msg[off + i * 4])) << 24 |
+                   static_cast<uint32_t>(static_cast<uint8_t>(msg[off + i * 4 + 1])) << 16 |
+                   static_cast<uint32_t>(static_cast<uint8_t>(msg[off + i * 4 + 2])) << 8 |
+                   static_cast<uint32_t>(static_cast<uint8_t>(msg[off + i * 4 + 3]));
+        for (int i = 16; i < 80; i++)
+            w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++)
+        {
+            uint32_t f, k;
+            if (i < 20)
+                f = (b & c) | (~b & d), k = 0x5A827999;
+            else if (i < 40)
+                f = b ^ c ^ d, k = 0x6ED9EBA1;
+            else if (i < 60)
+                f = (b & c) | (b & d) | (c & d), k = 0x8F1BBCDC;
+            else
+                f = b ^ c ^ d, k = 0xCA62C1D6;
+            uint32_t t = rol(a, 5) + f + e + k + w[i];
+            e = d, d = c, c = rol(b, 30), b = a, a = t;
+        }
+        h[0] += a, h[1] += b, h[2] += c, h[3] += d, h[4] += e;
+    }
+    std::array<uint8_t, 20> res;
+    for (int i = 0; i < 20; i++)
+        res[i] = static_cast<uint8_t>(h[i / 4] >> (24 - i % 4 * 8));
+    return res;
+}
+
+//! Base64 编码
+inline std::string base64(const uint8_t *data, size_t len)
+{
+    static const char TABLE[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string res;
+    for (size_t i = 0; i < len; i += 3)
+    {
+        uint32_t v = data[i] << 16 | (i + 1 < len ? data[i + 1] << 8 : 0) | (i + 2 < len ? data[i + 2] : 0);
+        res += TABLE[v >> 18 & 63];
+        res += TABLE[v >> 12 & 63];
+        res += i + 1 < len ? TABLE[v >> 6 & 63] : '=';
+        res += i + 2 < len ? TABLE[v & 63] : '=';
+    }
+    return res;
+}
+
+/**
+ * @brief 本地网页拓扑视图
+ * @details 在回环地址上提供一个不依赖外部资源的页面，页面以 canvas 绘制拓扑，并通过 WebSocket 接收二进制帧：
+ *          连接建立后先收到完整快照，此后只收到增量。拓扑事件在服务端按 `FLUSH_INTERVAL` 合并：同一节点的多次上下线
+ *          只保留最终状态，同一 (节点, 话题, 方向) 的端点增减相抵后只发送净变化，因而突发的大量事件只产生一帧。
+ *
+ *          帧内整数均为小端序，节点以 GUID 前缀（48 位，以 float64 表示）标识：
+ *          `u8 类型(1 快照 | 2 增量)`，`u32 n` 个上线节点 `{f64 前缀, u16 长度, 节点名}`，
+ *          `u32 n` 个端点变化 `{f64 前缀, u16 长度, 话题名, u8 是否发布, i32 数量变化}`，`u32 n` 个下线节点 `{f64 前缀}`。
+ *          快照中端点变化即为当前数量。节点下线不隐含其端点移除，与 `TopologyEvent` 的语义一致
+ */
+class WebUi
+{
+public:
+    static constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(100); //!< 增量合并周期
+    static constexpr size_t MAX_BACKLOG = 16 << 20;                         //!< 单个连接允许积压的字节数，超出时断开
+
+    explicit WebUi(Inspector &inspector) : inspector(inspector) {}
+    WebUi(const WebUi &) = delete;
+    WebUi &operator=(const WebUi &) = delete;
+    ~WebUi() { stop(); }
+
+    /**
+     * @brief 在 `127.0.0.1:port` 上开始服务
+     * @param[in] port 端口
+     * @param[out] err 失败原因
+     * @return 是否启动成功
+     */
+    bool start(uint16_t port, std::string *err = nullptr)
+    {
+        listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        int on = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(listen_fd, 16) != 0)
+        {
+            if (err)
+                *err = "Cannot listen on 127.0.0.1:" + std::to_string(port) + ": " + strerror(errno);
+            if (listen_fd >= 0)
+                close(listen_fd), listen_fd = -1;
+            return false;
+        }
+        sub = inspector.subscribe([this](const TopologyEvent &e) { on_event(e); });
+        running = true;
+        worker = std::thread([this] { run(); });
+        return true;
+    }
+
+    //! 停止服务并断开全部连接
+    void stop()
+    {
+        if (!running)
+            return;
+        inspector.unsubscribe(sub);
+        running = false;
+        worker.join();
+        for (auto &c : clients)
+            close(c.fd);
+        clients.clear();
+        close(listen_fd), listen_fd = -1;
+    }
+
+private:
+    struct Client
+    {
+        int fd;
+        std::string in;   //!< 未处理的输入
+        std::string out;  //!< 待发送的输出
+        bool ws{};        //!< 是否已升级为 WebSocket
+        bool closing{};   //!< 输出发送完毕后关闭
+        bool counted{};   //!< 是否已计入 `web.clients`
+    };
+
+    //! 合并中的增量
+    struct Pending
+    {
+        std::unordered_map<uint64_t, std::pair<bool, std::string>> nodes; //!< 前缀 -> (是否在线, 节点名)
+        std::map<std::tuple<uint64_t, std::string, bool>, int32_t> edges; //!< (前缀, 话题, 是否发布) -> 数量变化
+
+        bool empty() const { return nodes.empty() && edges.empty(); }
+    };
+
+    //! 拓扑事件回调，在持有 `state().mtx` 时调用
+    void on_event(const TopologyEvent &e)
+    {
+        static const auto events = metrics().counter("web.events");
+        events.add();
+        std::lock_guard<std::mutex> lock(mtx);
+        switch (e.kind)
+        {
+        case TopologyEvent::Kind::NodeUp:
+            pending.nodes[e.prefix] = {true, std::string(e.name)};
+            break;
+        case TopologyEvent::Kind::NodeDown:
+            pending.nodes[e.prefix] = {false, {}};
+            break;
+        case TopologyEvent::Kind::EndpointAdded:
+        case TopologyEvent::Kind::EndpointRemoved: {
+            auto it = pending.edges.try_emplace({e.prefix, std::string(e.topic), e.is_pub}).first;
+            if ((it->second += e.kind == TopologyEvent::Kind::EndpointAdded ? 1 : -1) == 0)
+                pending.edges.erase(it);
+            break;
+        }
+        }
+    }
+
+    static void put_u8(std::string &b, uint8_t v) { b += static_cast<char>(v); }
+    static void put_u16(std::string &b, uint16_t v) { put_u8(b, v & 0xFF), put_u8(b, v >> 8); }
+    static void put_u32(std::string &b, uint32_t v) { put_u16(b, v & 0xFFFF), put_u16(b, v >> 16); }
+    static void put_f64(std::string &b, double v)
+    {
+        uint64_t u;
+        memcpy(&u, &v, sizeof(u));
+        put_u32(b, static_cast<uint32_t>(u)), put_u32(b, static_cast<uint32_t>(u >> 32));
+    }
+    static void put_str(std::string &b, std::string_view s)
+    {
+        s = s.substr(0, UINT16_MAX);
+        put_u16(b, static_cast<uint16_t>(s.size()));
+        b += s;
+    }
+
+    //! 将增量编码为帧负载
+    static std::string encode(uint8_t type, const Pending &p)
+    {
+        std::string b;
+        put_u8(b, type);
+        uint32_t ups = 0, downs = 0;
+        for (auto &[prefix, node] : p.nodes)
+            node.first ? ups++ : downs++;
+        put_u32(b, ups);
+        for (auto &[prefix, node] : p.nodes)
+            if (node.first)
+                put_f64(b, static_cast<double>(prefix)), put_str(b, node.second);
+        put_u32(b, static_cast<uint32_t>(p.edges.size()));
+        for (auto &[key, delta] : p.edges)
+        {
+            put_f64(b, static_cast<double>(std::get<0>(key)));
+            put_str(b, std::get<1>(key));
+            put_u8(b, std::get<2>(key));
+            put_u32(b, static_cast<uint32_t>(delta));
+        }
+        put_u32(b, downs);
+        for (auto &[prefix, node] : p.nodes)
+            if (!node.first)
+                put_f64(b, static_cast<double>(prefix));
+        return b;
+    }
+
+    //! 以二进制 WebSocket 帧追加到连接的输出
+    static void frame(Client &c, std::string_view payload)
+    {
+        static const auto frames = metrics().counter("web.frames");
+        static const auto bytes = metrics().counter("web.bytes");
+        put_u8(c.out, 0x82);
+        if (payload.size() < 126)
+            put_u8(c.out, static_cast<uint8_t>(payload.size()));
+        else if (payload.size() <= UINT16_MAX)
+            put_u8(c.out, 126), put_u8(c.out, payload.size() >> 8), put_u8(c.out, payload.size() & 0xFF);
+        else
+        {
+            put_u8(c.out, 127);
+            for (int i = 7; i >= 0; i--)
+                put_u8(c.out, static_cast<uint8_t>(static_cast<uint64_t>(payload.size()) >> (i * 8)));
+        }
+        c.out += payload;
+        frames.add();
+        bytes.add(payload.size());
+    }
+
+    //! 向已有连接发送积累的增量
+    void flush(Pending &p)
+    {
+        if (p.empty())
+            return;
+        auto payload = encode(2, p);
+        for (auto &c : clients)
+            if (c.ws)
+                frame(c, payload);
+        p = {};
+    }
+
+    /**
+     * @brief 完成握手后发送快照
+     * @note 同时持有 `state().mtx` 与 `mtx`，先将此前积累的增量发给已有连接，再由状态生成快照，之后的事件只会进入
+     *       新的增量，快照与增量之间既无遗漏也无重复
+     */
+    void attach(Client &c)
+    {
+        auto &state = inspector.state();
+        std::lock_guard<std::mutex> state_lock(state.mtx);
+        std::lock_guard<std::mutex> lock(mtx);
+        flush(pending);
+        Pending snap;
+        for (auto &[prefix, node] : state.nodes)
+            if (!node.held) // 被保留的节点已发布过下线事件
+                snap.nodes[prefix] = {true, std::string(state.names.str(node.name_id))};
+        for (auto &[prefix, endpoints] : state.topics)
+            for (auto &[guid, ep] : endpoints)
+                snap.edges[{prefix, std::string(state.names.str(ep.topic_id)), ep.is_pub}]++;
+        c.ws = true;
+        frame(c, encode(1, snap));
+    }
+
+    //! 处理 HTTP 请求或 WebSocket 帧
+    void handle_input(Client &c)
+    {
+        if (!c.ws)
+        {
+            auto end = c.in.find("\r\n\r\n");
+            if (end == std::string::npos)
+            {
+                if (c.in.size() > 8192)
+                    c.closing = true;
+                return;
+            }
+            std::string req = c.in.substr(0, end + 2);
+            c.in.erase(0, end + 4);
+            auto header = [&](const char *name) -> std::string {
+                for (size_t pos = req.find("\r\n"); pos != std::string::npos && pos + 2 < req.size();)
+                {
+                    size_t eol = req.find("\r\n", pos + 2);
+                    std::string line = req.substr(pos + 2, eol - pos - 2);
+                    pos = eol;
+                    if (line.size() > strlen(name) && !strncasecmp(line.c_str(), name, strlen(name)) && line[strlen(name)] == ':')
+                    {
+                        size_t v = line.find_first_not_of(' ', strlen(name) + 1);
+                        return v == std::string::npos ? "" : line.substr(v);
+                    }
+                }
+                return {};
+            };
+            std::string key = header("Sec-WebSocket-Key");
+            if (!req.compare(0, 8, "GET /ws ") && !key.empty())
+            {
+                auto digest = sha1(key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+                c.out += "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                         "Sec-WebSocket-Accept: " + base64(digest.data(), digest.size()) + "\r\n\r\n";
+                attach(c);
+            }
+            else if (!req.compare(0, 6, "GET / ") || !req.compare(0, 16, "GET /index.html "))
+            {
+                c.out += "HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=utf-8\r\nCache-Control: no-store\r\n"
+                         "Content-Length: " + std::to_string(strlen(PAGE)) + "\r\nConnection: close\r\n\r\n";
+                c.out += PAGE;
+                c.closing = true;
+            }
+            else
+            {
+                c.out += "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+                c.closing = true;
+            }
+            return;
+        }
+        // 客户端帧：只处理 ping 与 close，其余丢弃
+        while (c.in.size() >= 2)
+        {
+            auto *p = reinterpret_cast<const uint8_t *>(c.in.data());
+            uint8_t opcode = p[0] & 0x0F;
+            uint64_t len = p[1] & 0x7F;
+            size_t head = 2;
+            if (len == 126)
+            {
+                if (c.in.size() < 4)
+                    return;
+                len = p[2] << 8 | p[3], head = 4;
+            }
+            else if (len == 127)
+            {
+                if (c.in.size() < 10)
+                    return;
+                len = 0;
+                for (int i = 0; i < 8; i++)
+                    len = len << 8 | p[2 + i];
+                head = 10;
+            }
+            bool masked = p[1] & 0x80;
+            size_t total = head + (masked ? 4 : 0) + len;
+            if (len > 65536)
+            {
+                c.closing = true;
+                return;
+            }
+            if (c.in.size() < total)
+                return;
+            std::string payload = c.in.substr(head + (masked ? 4 : 0), len);
+            if (masked)
+                for (size_t i = 0; i < payload.size(); i++)
+                    payload[i] ^= p[head + i % 4];
+            c.in.erase(0, total);
+            if (opcode == 0x8)
+            {
+                c.out += "\x88";
+                c.out += '\0';
+                c.closing = true;
+                return;
+            }
+            if (opcode == 0x9)
+            {
+                put_u8(c.out, 0x8A), put_u8(c.out, static_cast<uint8_t>(std::min<size_t>(payload.size(), 125)));
+                c.out += payload.substr(0, 125);
+            }
+        }
+    }
+
+    void run()
+    {
+        auto placed = ThreadPlacement::global().enter(ThreadPlacement::Exporter, "lpss-web");
+        auto connected = metrics().gauge("web.clients");
+        auto next_flush = std::chrono::steady_clock::now() + FLUSH_INTERVAL;
+        std::vector<pollfd> fds;
+        char buf[16384];
+        while (running)
+        {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= next_flush)
+            {
+                Pending batch;
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    std::swap(batch, pending);
+                }
+                flush(batch);
+                next_flush = now + FLUSH_INTERVAL;
+            }
+
+            fds.assign(1, {listen_fd, POLLIN, 0});
+            for (auto &c : clients)
+                fds.push_back({c.fd, static_cast<short>(POLLIN | (c.out.empty() ? 0 : POLLOUT)), 0});
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next_flush - now).count();
+            if (poll(fds.data(), fds.size(), static_cast<int>(std::max<int64_t>(wait, 1))) < 0)
+                continue;
+
+            for (size_t i = 0; i < clients.size(); i++)
+            {
+                auto &c = clients[i];
+                short ev = fds[i + 1].revents;
+                bool dead = ev & (POLLERR | POLLNVAL);
+                if (ev & (POLLIN | POLLHUP))
+                {
+                    ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+                    if (n > 0)
+                        c.in.append(buf, n), handle_input(c);
+                    else if (n == 0 || (errno != EAGAIN && errno != EINTR))
+                        dead = true;
+                }
+                if (!c.out.empty() && !dead)
+                {
+                    ssize_t n = send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+                    if (n > 0)
+                        c.out.erase(0, n);
+                    else if (n < 0 && errno != EAGAIN && errno != EINTR)
+                        dead = true;
+                }
+                // 积压过多的慢速连接直接断开，页面重连后重新取得快照
+                if (dead || c.out.size() > MAX_BACKLOG || (c.closing && c.out.empty()))
+                {
+                    close(c.fd);
+                    if (c.counted)
+                        connected.sub(1);
+                    clients.erase(clients.begin() + i);
+                    fds.erase(fds.begin() + i + 1);
+                    i--;
+                }
+            }
+            // 新连接在本轮之后加入，以免与 `fds` 的下标错位
+            if (fds[0].revents & POLLIN)
+            {
+                int fd;
+                while ((fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK)) >= 0)
+                    clients.push_back({fd, {}, {}});
+            }
+            for (auto &c : clients)
+                if (c.ws && !c.counted)
+                    c.counted = true, connected.add(1);
+        }
+        for (auto &c : clients)
+            if (c.counted)
+                connected.sub(1);
+    }
+
+    static constexpr const char *PAGE = R"HTML(<!DOCTYPE html>
+<html><head><meta charset="utf-8"><title>LPSS topology</title>
+<style>
+html,body{margin:0;height:100%;overflow:hidden;background:#fafafa;font:12px sans-serif}
+canvas{display:block}
+#hud{position:fixed;left:8px;top:8px;background:rgba(255,255,255,.85);padding:4px 8px;border:1px solid #ccc;white-space:pre}
+</style></head>
+<body><canvas id="c"></canvas><div id="hud">connecting...</div>
+<script>
+"use strict";
+const cv = document.getElementById("c"), ctx = cv.getContext("2d"), hud = document.getElementById("hud");
+const K = 40, CELL = 2 * K;
+let nodes = new Map(), topics = new Map(), edges = new Map(), links = new Map();
+let hot = new Set(), dirty = true, view = {x: 0, y: 0, s: 1}, frames = 0, bytes = 0, lastSize = 0, fps = 0;
+
+function hash(s) { let h = 2166136261; for (let i = 0; i < s.length; i++) h = Math.imul(h ^ s.charCodeAt(i), 16777619); return h >>> 0; }
+function seed(key, r) { const h = hash(String(key)); return {x: ((h & 0xffff) / 65536 - .5) * r, y: ((h >>> 16) / 65536 - .5) * r}; }
+function spread() { return Math.sqrt(nodes.size + topics.size + 1) * K; }
+
+// 各顶点关联的边，节点以前缀、话题以 "t" + 话题名为键，节点下线重连后仍能找回其边
+function link(k, e, add) {
+  let s = links.get(k);
+  if (add) { if (!s) links.set(k, s = new Set()); s.add(e); }
+  else if (s) { s.delete(e); if (!s.size) links.delete(k); }
+}
+function neighbours(a) {
+  const res = [], isNode = a.p !== undefined;
+  for (const e of links.get(isNode ? a.p : "t" + a.name) || []) {
+    const b = isNode ? topics.get(e.topic) : nodes.get(e.p);
+    if (b) res.push(b);
+  }
+  return res;
+}
+
+function topicRef(name, d) {
+  let t = topics.get(name);
+  if (!t) { if (d <= 0) return; t = Object.assign(seed(name, spread()), {name, n: 0}); topics.set(name, t); hot.add(t); }
+  t.n += d;
+  if (t.n <= 0) { topics.delete(name); hot.delete(t); }
+}
+
+function apply(buf) {
+  const v = new DataView(buf), dec = new TextDecoder();
+  let o = 0;
+  const u8 = () => v.getUint8(o++), u16 = () => { const x = v.getUint16(o, true); o += 2; return x; };
+  const u32 = () => { const x = v.getUint32(o, true); o += 4; return x; }, i32 = () => { const x = v.getInt32(o, true); o += 4; return x; };
+  const f64 = () => { const x = v.getFloat64(o, true); o += 8; return x; };
+  const str = () => { const n = u16(); const s = dec.decode(new Uint8Array(buf, o, n)); o += n; return s; };
+  const snapshot = u8() === 1;
+  if (snapshot) { nodes = new Map(); topics = new Map(); edges = new Map(); links = new Map(); hot = new Set(); }
+  for (let n = u32(); n--; ) {
+    const p = f64(), name = str();
+    let node = nodes.get(p);
+    if (!node) { node = Object.assign(seed(p, spread()), {p, fresh: true}); nodes.set(p, node); hot.add(node); }
+    node.name = name;
+  }
+  for (let n = u32(); n--; ) {
+    const p = f64(), topic = str(), pub = u8(), d = i32(), key = p + "|" + pub + "|" + topic;
+    let e = edges.get(key);
+    if (!e) { if (d <= 0) continue; e = {p, topic, pub, n: 0}; edges.set(key, e); link(p, e, true); link("t" + topic, e, true); }
+    e.n += d;
+    topicRef(topic, d);
+    if (e.n <= 0) { edges.delete(key); link(p, e, false); link("t" + topic, e, false); }
+    const node = nodes.get(p), t = topics.get(topic);
+    // 新节点直接放到其话题旁边，只需少量迭代即可稳定
+    if (node && t && node.fresh) { const j = seed(p, K); node.x = t.x + j.x; node.y = t.y + j.y; node.fresh = false; }
+    if (node) hot.add(node);
+    if (t) hot.add(t);
+  }
+  for (let n = u32(); n--; ) { const node = nodes.get(f64()); if (node) { nodes.delete(node.p); hot.delete(node); } }
+  if (snapshot) initial();
+  // 快照已有较好的初始位置，只需少量迭代
+  for (const x of hot) { x.heat = snapshot ? 20 : 60; x.fresh = false; }
+  dirty = true;
+}
+
+// 快照的初始布局：话题均匀散布，节点位于其话题的重心
+function initial() {
+  const r = spread(), acc = new Map();
+  for (const t of topics.values()) Object.assign(t, seed(t.name, r));
+  for (const e of edges.values()) {
+    const t = topics.get(e.topic);
+    if (!t) continue;
+    const a = acc.get(e.p) || {x: 0, y: 0, n: 0};
+    a.x += t.x; a.y += t.y; a.n++; acc.set(e.p, a);
+  }
+  for (const n of nodes.values()) {
+    const a = acc.get(n.p), j = seed(n.p, K);
+    if (a) { n.x = a.x / a.n + j.x; n.y = a.y / a.n + j.y; } else Object.assign(n, seed(n.p, r));
+  }
+}
+
+// 只迭代最近变化的顶点，其余顶点保持不动；每帧至多处理 BUDGET 个，快照之后也能保持交互帧率
+const BUDGET = 600;
+function relax() {
+  if (!hot.size) return;
+  const batch = [];
+  for (const a of hot) if (batch.push(a) >= BUDGET) break;
+  const grid = new Map(), cell = (x, y) => Math.floor(x / CELL) * 1e6 + Math.floor(y / CELL);
+  for (const m of [nodes, topics]) for (const a of m.values()) { const c = cell(a.x, a.y); let g = grid.get(c); if (!g) grid.set(c, g = []); g.push(a); }
+  for (const a of batch) {
+    let dx = 0, dy = 0;
+    const cx = Math.floor(a.x / CELL), cy = Math.floor(a.y / CELL);
+    for (let i = -1; i <= 1; i++) for (let j = -1; j <= 1; j++) {
+      const g = grid.get((cx + i) * 1e6 + cy + j);
+      if (g) for (const b of g) {
+        if (b === a) continue;
+        let vx = a.x - b.x, vy = a.y - b.y, d2 = vx * vx + vy * vy;
+        if (d2 < .01) { vx = Math.random() - .5; vy = Math.random() - .5; d2 = .01; }
+        if (d2 > CELL * CELL) continue;
+        dx += vx * K * K / d2; dy += vy * K * K / d2;
+      }
+    }
+    for (const b of neighbours(a)) { const vx = a.x - b.x, vy = a.y - b.y, f = Math.sqrt(vx * vx + vy * vy) / K; dx -= vx * f; dy -= vy * f; }
+    const len = Math.sqrt(dx * dx + dy * dy), t = a.heat * K / 60;
+    if (len > t) { dx *= t / len; dy *= t / len; }
+    a.x += dx; a.y += dy;
+    if (--a.heat <= 0) hot.delete(a);
+  }
+  dirty = true;
+}
+
+function draw() {
+  const w = cv.width = innerWidth, h = cv.height = innerHeight;
+  ctx.setTransform(view.s, 0, 0, view.s, w / 2 + view.x, h / 2 + view.y);
+  ctx.lineWidth = 1 / view.s;
+  for (const pub of [1, 0]) {
+    ctx.beginPath();
+    for (const e of edges.values()) {
+      if (e.pub !== pub) continue;
+      const a = nodes.get(e.p), b = topics.get(e.topic);
+      if (a && b) { ctx.moveTo(a.x, a.y); ctx.lineTo(b.x, b.y); }
+    }
+    ctx.strokeStyle = pub ? "rgba(0,0,255,.35)" : "rgba(0,128,0,.35)";
+    ctx.stroke();
+  }
+  const r = Math.max(3, 2 / view.s);
+  ctx.beginPath();
+  for (const a of nodes.values()) ctx.rect(a.x - r, a.y - r, 2 * r, 2 * r);
+  ctx.fillStyle = "#6fa8dc"; ctx.fill();
+  ctx.beginPath();
+  for (const t of topics.values()) { ctx.moveTo(t.x + r, t.y); ctx.arc(t.x, t.y, r, 0, 2 * Math.PI); }
+  ctx.fillStyle = "#e6c84a"; ctx.fill();
+  if (view.s > 1.2) {
+    ctx.fillStyle = "#333"; ctx.font = 11 / view.s + "px sans-serif";
+    const x0 = (-w / 2 - view.x) / view.s, x1 = (w / 2 - view.x) / view.s, y0 = (-h / 2 - view.y) / view.s, y1 = (h / 2 - view.y) / view.s;
+    let labels = 0;
+    for (const m of [nodes, topics]) for (const a of m.values())
+      if (a.x > x0 && a.x < x1 && a.y > y0 && a.y < y1 && labels++ < 800) ctx.fillText(a.name, a.x + r + 2 / view.s, a.y + 3 / view.s);
+  }
+  hud.textContent = `${nodes.size} nodes, ${topics.size} topics, ${edges.size} edges\n` +
+    `${frames} frames, ${(bytes / 1024).toFixed(1)} KiB, last ${lastSize} B, ${fps} fps`;
+}
+
+let count = 0, since = performance.now();
+function tick(now) {
+  relax();
+  if (dirty) { draw(); dirty = false; count++; }
+  if (now - since >= 1000) { fps = count; count = 0; since = now; dirty = true; }
+  requestAnimationFrame(tick);
+}
+requestAnimationFrame(tick);
+
+function connect() {
+  const ws = new WebSocket(`ws://${location.host}/ws`);
+  ws.binaryType = "arraybuffer";
+  ws.onmessage = m => { frames++; bytes += m.data.byteLength; lastSize = m.data.byteLength; apply(m.data); };
+  ws.onclose = () => { hud.textContent = "disconnected, retrying..."; setTimeout(connect, 1000); };
+}
+connect();
+
+let drag = null;
+cv.onmousedown = e => drag = {x: e.clientX - view.x, y: e.clientY - view.y};
+window.onmouseup = () => drag = null;
+window.onmousemove = e => { if (drag) { view.x = e.clientX - drag.x; view.y = e.clientY - drag.y; dirty = true; } };
+cv.onwheel = e => {
+  e.preventDefault();
+  const f = Math.exp(-e.deltaY / 500), mx = e.clientX - innerWidth / 2, my = e.clientY - innerHeight / 2;
+  view.x = mx - (mx - view.x) * f; view.y = my - (my - view.y) * f; view.s *= f; dirty = true;
+};
+window.onresize = () => dirty = true;
+</script></body></html>
+)HTML";
+
+    Inspector &inspector;
+    size_t sub{};
+    int listen_fd{-1};
+    std::atomic<bool> running{};
+    std::thread worker;
+    std::mutex mtx;          //!< 保护 `pending`
+    Pending pending;         //!< 合并中的增量
+    std::vector<Client> clients; //!< 仅由服务线程访问
+};
@@ -0,0 +1,115 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "inspector.hpp"
+#include "node_simulator.hpp"
+#include "thread_placement.hpp"
+
+using namespace std::chrono_literals;
+
+//! 一个损伤场景的测量结果
+struct Result
+{
+    double converge_s;     //!< 全部节点与端点被发现的耗时，未收敛时为负
+    uint64_t false_expiry; //!< 浸泡期间模拟节点的超时次数，模拟节点始终在线，因此每次超时都是误判
+    double cpu_pct;        //!< 浸泡期间收包与心跳线程的 CPU 占用（单核百分比）
+    ImpairedLink::Stats link;
+};
+
+Result run(const ImpairmentProfile &profile, size_t nodes, size_t endpoints, std::chrono::seconds soak)
+{
+    Result res{};
+    Inspector inspector;
+    std::string err;
+    if (!inspector.start(&err))
+    {
+        printf("Failed to start inspector: %s\n", err.c_str());
+        exit(1);
+    }
+    SimOptions opts;
+    opts.nodes = nodes;
+    opts.endpoints = endpoints;
+    opts.impair = profile;
+    std::atomic<uint64_t> downs{};
+    size_t sub = inspector.subscribe([&](const TopologyEvent &ev) {
+        if (ev.kind == TopologyEvent::Kind::NodeDown && static_cast<uint32_t>(ev.prefix) == opts.host)
+            downs++;
+    });
+
+    // 1. 收敛：自启动模拟器起，至检查器发现全部节点与端点
+    NodeSimulator sim(opts);
+    auto t0 = std::chrono::steady_clock::now();
+    sim.start();
+    res.converge_s = -1;
+    while (std::chrono::steady_clock::now() - t0 < 30s)
+    {
+        std::this_thread::sleep_for(50ms);
+        auto topo = inspector.topology();
+        size_t n = 0, e = 0;
+        for (auto &node : topo.nodes)
+            n += static_cast<uint32_t>(node.prefix) == opts.host;
+        for (auto &ep : topo.endpoints)
+            e += static_cast<uint32_t>(ep.node) == opts.host;
+        if (n == nodes && e == nodes * endpoints)
+        {
+            res.converge_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            break;
+        }
+    }
+
+    // 2. 浸泡：统计误判超时与 CPU 占用
+    auto &placement = ThreadPlacement::global();
+    auto cpu0 = placement.cpu_time();
+    uint64_t downs0 = downs;
+    auto s0 = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(soak);
+    auto cpu1 = placement.cpu_time();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - s0).count();
+    uint64_t used = 0;
+    for (auto cls : {ThreadPlacement::Receive, ThreadPlacement::Heartbeat})
+        used += cpu1[cls] - cpu0[cls];
+    res.false_expiry = downs - downs0;
+    res.cpu_pct = used / 1e9 / wall * 100;
+    res.link = sim.link_stats();
+
+    sim.stop();
+    inspector.unsubscribe(sub);
+    inspector.stop();
+    return res;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t nodes = argc > 1 ? std::stoul(argv[1]) : 200;
+    size_t endpoints = argc > 2 ? std::stoul(argv[2]) : 4;
+    auto soak = std::chrono::seconds(argc > 3 ? std::stoul(argv[3]) : 20);
+
+    // 浸泡时长应覆盖数个 NODE_TTL，才能暴露成串丢包导致的误判超时
+    static const std::pair<const char *, const char *> PROFILES[] = {
+        {"clean", ""},
+        {"wifi", "loss=2%,burst=3,delay=3ms,jitter=15ms,reorder=2%,dup=1%"},
+        {"lossy-wifi", "loss=10%,burst=4,delay=5ms,jitter=40ms,reorder=5%,dup=2%"},
+        {"congested", "loss=30%,burst=8,delay=50ms,jitter=100ms"},
+    };
+    printf("[Impairment] %zu nodes x %zu endpoints, soak %lds\n", nodes, endpoints, static_cast<long>(soak.count()));
+    printf("%-12s %10s %13s %8s %10s %10s\n", "profile", "converge", "false-expiry", "cpu", "dropped", "reordered");
+    for (auto [label, spec] : PROFILES)
+    {
+        ImpairmentProfile profile;
+        std::string err;
+        profile.parse(spec, err);
+        auto r = run(profile, nodes, endpoints, soak);
+        char converge[32];
+        if (r.converge_s < 0)
+            snprintf(converge, sizeof(converge), "timeout");
+        else
+            snprintf(converge, sizeof(converge), "%.2fs", r.converge_s);
+        printf("%-12s %10s %13lu %7.1f%% %10lu %10lu\n", label, converge, static_cast<unsigned long>(r.false_expiry), r.cpu_pct,
+               static_cast<unsigned long>(r.link.dropped), static_cast<unsigned long>(r.link.reordered));
+    }
+}
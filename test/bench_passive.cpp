@@ -0,0 +1,117 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "inspector.hpp"
+#include "metrics.hpp"
+#include "node_simulator.hpp"
+#include "thread_placement.hpp"
+
+using namespace std::chrono_literals;
+
+//! 一种模式的测量结果
+struct Result
+{
+    double converge_s;  //!< 全部节点与端点被发现的耗时，未收敛时为负
+    double cpu_pct;     //!< 浸泡期间收包与心跳线程的 CPU 占用（单核百分比）
+    double induced_pps; //!< 浸泡期间检查器发出及诱发的报文速率
+};
+
+Result run(bool passive, const std::string &iface, size_t nodes, size_t endpoints, std::chrono::seconds soak)
+{
+    // 1. 两组模拟节点互相通告定位器并交换 REDP，被动模式只能从这些交换中看到端点
+    SimOptions a, b;
+    a.nodes = b.nodes = nodes / 2;
+    a.endpoints = b.endpoints = endpoints;
+    a.host = 0x5100, b.host = 0x5200;
+    a.locator_ip = b.locator_ip = "127.0.0.1";
+    NodeSimulator sim_a(a), sim_b(b);
+    sim_a.start(), sim_b.start();
+    // 先让两组模拟节点互相发现，使检查器启动时两组之间已在交换 REDP
+    while (sim_a.peers() < 1 || sim_b.peers() < 1)
+        std::this_thread::sleep_for(50ms);
+
+    InspectorOptions opts;
+    opts.passive = passive;
+    opts.capture_if = iface;
+    Inspector inspector(opts);
+    std::string err;
+    if (!inspector.start(&err))
+    {
+        printf("Failed to start inspector: %s\n", err.c_str());
+        exit(1);
+    }
+
+    // 2. 收敛：自检查器启动起，至发现全部模拟节点与端点
+    Result res{-1, 0, 0};
+    size_t total = a.nodes + b.nodes;
+    auto t0 = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - t0 < 30s)
+    {
+        std::this_thread::sleep_for(20ms);
+        auto topo = inspector.topology();
+        size_t n = 0, e = 0;
+        for (auto &node : topo.nodes)
+            n += static_cast<uint32_t>(node.prefix) == a.host || static_cast<uint32_t>(node.prefix) == b.host;
+        for (auto &ep : topo.endpoints)
+            e += static_cast<uint32_t>(ep.node) == a.host || static_cast<uint32_t>(ep.node) == b.host;
+        if (n == total && e == total * endpoints)
+        {
+            res.converge_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            break;
+        }
+    }
+
+    // 3. 浸泡：CPU 占用，以及检查器发出的心跳与模拟节点因其存在而发给它的 REDP
+    InspectorOptions defaults;
+    auto heartbeats = [] {
+        for (auto &m : metrics().collect())
+            if (m.name == "heartbeat.sent")
+                return static_cast<uint64_t>(m.value);
+        return uint64_t{0};
+    };
+    auto induced = [&] {
+        auto host = static_cast<uint32_t>(defaults.guid);
+        return heartbeats() + sim_a.sent_to(host) + sim_b.sent_to(host);
+    };
+    auto &placement = ThreadPlacement::global();
+    auto cpu0 = placement.cpu_time();
+    auto p0 = induced();
+    auto w0 = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(soak);
+    auto cpu1 = placement.cpu_time();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - w0).count();
+    uint64_t used = 0;
+    for (auto cls : {ThreadPlacement::Receive, ThreadPlacement::Heartbeat})
+        used += cpu1[cls] - cpu0[cls];
+    res.cpu_pct = used / 1e9 / wall * 100;
+    res.induced_pps = (induced() - p0) / wall;
+
+    inspector.stop();
+    sim_a.stop(), sim_b.stop();
+    return res;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t nodes = argc > 1 ? std::stoul(argv[1]) : 200;
+    size_t endpoints = argc > 2 ? std::stoul(argv[2]) : 4;
+    auto soak = std::chrono::seconds(argc > 3 ? std::stoul(argv[3]) : 10);
+    std::string iface = argc > 4 ? argv[4] : "";
+
+    printf("[Passive] %zu nodes x %zu endpoints, soak %lds, capture on %s\n", nodes, endpoints, static_cast<long>(soak.count()),
+           iface.empty() ? "all interfaces" : iface.c_str());
+    printf("%-8s %10s %8s %14s\n", "mode", "converge", "cpu", "induced pkt/s");
+    for (bool passive : {false, true})
+    {
+        auto r = run(passive, iface, nodes, endpoints, soak);
+        char converge[32];
+        if (r.converge_s < 0)
+            snprintf(converge, sizeof(converge), "timeout");
+        else
+            snprintf(converge, sizeof(converge), "%.2fs", r.converge_s);
+        printf("%-8s %10s %7.1f%% %14.1f\n", passive ? "passive" : "active", converge, r.cpu_pct, r.induced_pps);
+    }
+}
@@ -0,0 +1,70 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <random>
+#include "string_pool.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+template <typename F>
+double measure_ms(F &&f, int rounds = 10)
+{
+    f(); // 预热
+    auto t0 = Clock::now();
+    for (int i = 0; i < rounds; i++)
+        f();
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count() / rounds;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+    // 1. 生成形如 "robot_17/camera_front_node_4711" 的名字
+    static const char *PARTS[] = {"camera", "lidar", "imu", "planner", "detector", "tracker", "controller", "odom"};
+    static const char *SIDES[] = {"front", "rear", "left", "right", "top"};
+    std::mt19937 rng(42);
+    std::vector<std::string> names;
+    names.reserve(count);
+    StringPool pool;
+    for (size_t i = 0; i < count; i++)
+    {
+        names.push_back("robot_" + std::to_string(rng() % 200) + "/" + PARTS[rng() % 8] + "_" + SIDES[rng() % 5] +
+                        "_node_" + std::to_string(i));
+        pool.intern(names.back());
+    }
+    std::cout << "[Names] " << count << " names, " << pool.bytes() / 1024 / 1024 << " MiB pool" << std::endl;
+
+    // 2. 子串检索：逐个 std::string::find 与整块向量化扫描
+    for (const char *needle : {"lidar_top", "robot_123/", "_node_99999", "zzz", "o"})
+    {
+        std::vector<uint32_t> naive, simd;
+        double t_naive = measure_ms([&] {
+            naive.clear();
+            for (uint32_t id = 0; id < names.size(); id++)
+                if (names[id].find(needle) != std::string::npos)
+                    naive.push_back(id);
+        });
+        double t_simd = measure_ms([&] { simd = pool.find(needle); });
+        std::cout << "[Substring] \"" << needle << "\": " << simd.size() << " hits, naive " << t_naive << " ms, pool "
+                  << t_simd << " ms, x" << t_naive / t_simd << (naive == simd ? "" : "  MISMATCH") << std::endl;
+    }
+
+    // 3. glob 检索：逐个 fnmatch 与字面量预筛选后核对
+    for (const char *pattern : {"robot_1*/lidar_*", "*tracker_rear_node_12?", "*camera*left*"})
+    {
+        GlobPattern glob(pattern);
+        std::vector<uint32_t> naive, fast;
+        double t_naive = measure_ms([&] {
+            naive.clear();
+            for (uint32_t id = 0; id < names.size(); id++)
+                if (fnmatch(pattern, names[id].c_str(), 0) == 0)
+                    naive.push_back(id);
+        });
+        double t_fast = measure_ms([&] { fast = pool.glob(glob); });
+        std::cout << "[Glob] \"" << pattern << "\": " << fast.size() << " hits, fnmatch " << t_naive << " ms, pool "
+                  << t_fast << " ms, x" << t_naive / t_fast << (naive == fast ? "" : "  MISMATCH") << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,242 @@
+/**
+ * @file net_impairment.hpp
+ * @author Nq139 (fnq409997@gmail.com)
+ * @brief 模拟丢包、时延、抖动、乱序与重复的 UDP 发送链路
+ * @copyright Copyright 2026, Nq139
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * @brief 链路损伤配置
+ * @details 文本形式为 `<key>=<value>[,<key>=<value>]...`，`key` 为
+ * - `loss`：丢包率，如 `5%`
+ * - `burst`：平均连续丢包长度，大于 1 时按 Gilbert 模型成串丢包，模拟 Wi-Fi 的突发干扰
+ * - `delay`：固定时延，如 `20ms`
+ * - `jitter`：时延在 `[-jitter, +jitter]` 内均匀抖动
+ * - `reorder`：报文被额外滞留、落后于之后发送的报文的概率
+ * - `dup`：报文被重复发送的概率
+ */
+struct ImpairmentProfile
+{
+    double loss{};                          //!< 丢包率
+    double burst{1};                        //!< 平均连续丢包长度
+    std::chrono::microseconds delay{};      //!< 固定时延
+    std::chrono::microseconds jitter{};     //!< 时延抖动幅度
+    double reorder{};                       //!< 乱序概率
+    double duplicate{};                     //!< 重复概率
+
+    /**
+     * @brief 解析文本形式的配置，空文本表示无损伤
+     * @param[in] spec 配置文本
+     * @param[out] err 错误描述
+     * @return 是否解析成功
+     */
+    bool parse(const std::string &spec, std::string &err)
+    {
+        *this = {};
+        for (size_t pos = 0; pos < spec.size();)
+        {
+            size_t end = std::min(spec.find(',', pos), spec.size()), eq = spec.find('=', pos);
+            if (eq == std::string::npos || eq > end)
+                return err = "expected <key>=<value> in '" + spec + "'", false;
+            std::string key = spec.substr(pos, eq - pos), value = spec.substr(eq + 1, end - eq - 1);
+            char *unit;
+            double v = strtod(value.c_str(), &unit);
+            std::string u = unit;
+            double scale = u == "%" ? 0.01 : u == "ms" ? 1000 : u == "us" ? 1 : u == "s" ? 1e6 : 1;
+            if (key == "loss")
+                loss = v * scale;
+            else if (key == "burst")
+                burst = std::max(1.0, v);
+            else if (key == "delay")
+                delay = std::chrono::microseconds(static_cast<int64_t>(v * (u.empty() ? 1000 : scale)));
+            else if (key == "jitter")
+                jitter = std::chrono::microseconds(static_cast<int64_t>(v * (u.empty() ? 1000 : scale)));
+            else if (key == "reorder")
+                reorder = v * scale;
+            else if (key == "dup")
+                duplicate = v * scale;
+            else
+                return err = "unknown impairment '" + key + "'", false;
+            pos = end + 1;
+        }
+        if (loss < 0 || loss >= 1 || reorder < 0 || reorder > 1 || duplicate < 0 || duplicate > 1)
+            return err = "probabilities must be within [0, 1)", false;
+        return true;
+    }
+
+    //! 文本形式
+    std::string describe() const
+    {
+        char buf[160];
+        snprintf(buf, sizeof(buf), "loss=%.1f%%,burst=%.1f,delay=%.1fms,jitter=%.1fms,reorder=%.1f%%,dup=%.1f%%", loss * 100,
+                 burst, delay.count() / 1000.0, jitter.count() / 1000.0, reorder * 100, duplicate * 100);
+        return buf;
+    }
+};
+
+/**
+ * @brief 带损伤的 UDP 发送链路
+ * @details `send()` 按配置决定丢弃、重复及各副本的发送时刻，再交给后台线程按时刻顺序发出。丢包采用两状态 Gilbert
+ *          模型：坏状态下全部丢弃，离开坏状态的概率为 `1 / burst`，进入坏状态的概率按平均丢包率反推
+ */
+class ImpairedLink
+{
+public:
+    //! 各类损伤的累计次数
+    struct Stats
+    {
+        uint64_t offered{};    //!< 提交的报文数
+        uint64_t dropped{};    //!< 丢弃数
+        uint64_t duplicated{}; //!< 额外发送的副本数
+        uint64_t reordered{};  //!< 被滞留以造成乱序的报文数
+        uint64_t sent{};       //!< 实际发出的报文数
+    };
+
+    ImpairedLink(const ImpairmentProfile &profile, uint64_t seed) : profile(profile), rng(seed)
+    {
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        unsigned char on = 1, ttl = 1;
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &on, sizeof(on));
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+        worker = std::thread([this] { run(); });
+    }
+
+    ImpairedLink(const ImpairedLink &) = delete;
+    ImpairedLink &operator=(const ImpairedLink &) = delete;
+
+    ~ImpairedLink()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_one();
+        worker.join();
+        close(fd);
+    }
+
+    /**
+     * @brief 经损伤链路发送一个报文
+     * @param[in] addr 目的 IPv4 地址（网络字节序）
+     * @param[in] port 目的端口
+     * @param[in] data 报文
+     */
+    void send(uint32_t addr, uint16_t port, std::string data)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        stats.offered++;
+        if (lost())
+        {
+            stats.dropped++;
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        int copies = uniform() < profile.duplicate ? 2 : 1;
+        stats.duplicated += copies - 1;
+        for (int i = 0; i < copies; i++)
+        {
+            auto lag = profile.delay + std::chrono::microseconds(static_cast<int64_t>((uniform() * 2 - 1) * profile.jitter.count()));
+            if (uniform() < profile.reorder)
+            {
+                // 滞留超过抖动范围，保证落后于其后发送的报文
+                lag += 2 * profile.jitter + std::chrono::milliseconds(5);
+                stats.reordered++;
+            }
+            queue.push({now + std::max(lag, std::chrono::microseconds::zero()), seq++, addr, port, i + 1 < copies ? data : std::move(data)});
+        }
+        lock.unlock();
+        cv.notify_one();
+    }
+
+    //! 各类损伤的累计次数
+    Stats snapshot()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stats;
+    }
+
+private:
+    struct Packet
+    {
+        std::chrono::steady_clock::time_point due;
+        uint64_t seq; //!< 同一时刻的报文保持提交顺序
+        uint32_t addr;
+        uint16_t port;
+        std::string data;
+
+        bool operator>(const Packet &other) const { return due != other.due ? due > other.due : seq > other.seq; }
+    };
+
+    double uniform() { return std::uniform_real_distribution<double>(0, 1)(rng); }
+
+    //! Gilbert 模型判定是否丢弃，调用方需持有 `mtx`
+    bool lost()
+    {
+        if (profile.loss <= 0)
+            return false;
+        double leave_bad = 1 / profile.burst;
+        double enter_bad = profile.loss * leave_bad / (1 - profile.loss);
+        bad = bad ? uniform() >= leave_bad : uniform() < enter_bad;
+        return bad;
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (!stopping)
+        {
+            if (queue.empty())
+            {
+                cv.wait(lock);
+                continue;
+            }
+            if (std::chrono::steady_clock::now() < queue.top().due)
+            {
+                cv.wait_until(lock, queue.top().due);
+                continue;
+            }
+            Packet p = std::move(const_cast<Packet &>(queue.top()));
+            queue.pop();
+            lock.unlock();
+            sockaddr_in to{};
+            to.sin_family = AF_INET;
+            to.sin_addr.s_addr = p.addr;
+            to.sin_port = htons(p.port);
+            bool ok = sendto(fd, p.data.data(), p.data.size(), 0, reinterpret_cast<sockaddr *>(&to), sizeof(to)) >= 0;
+            lock.lock();
+            stats.sent += ok;
+        }
+    }
+
+    ImpairmentProfile profile;
+    std::mt19937_64 rng;
+    bool bad{}; //!< Gilbert 模型的当前状态
+    int fd{-1};
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::priority_queue<Packet, std::vector<Packet>, std::greater<Packet>> queue;
+    uint64_t seq{};
+    Stats stats;
+    bool stopping{};
+    std::thread worker;
+};
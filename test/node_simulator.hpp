@@ -0,0 +1,212 @@
+/**
+ * @file node_simulator.hpp
+ * @author Nq139 (fnq409997@gmail.com)
+ * @brief 批量模拟 LPSS 节点的发现报文
+ * @copyright Copyright 2026, Nq139
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <arpa/inet.h>
+
+#include <rmvl/lpss.hpp>
+
+#include "net_impairment.hpp"
+#include "udp_receiver.hpp"
+
+//! 模拟器配置
+struct SimOptions
+{
+    size_t nodes{100};                                   //!< 节点数
+    size_t endpoints{4};                                 //!< 每个节点的端点数
+    size_t topics{50};                                   //!< 话题总数
+    std::chrono::milliseconds period{1000};              //!< RNDP 通告周期
+    std::chrono::milliseconds redp_refresh{5000};        //!< 向已发现的对端重发 REDP 的周期，为 0 时只在发现对端后发送一轮
+    std::string group{rm::lpss::BROADCAST_IP};           //!< RNDP 目的地址
+    uint16_t port{7500};                                 //!< RNDP 端口
+    uint32_t host{0x5100};                               //!< GUID 的 host 字段，区分不同的模拟器实例
+    std::string locator_ip;                              //!< 非空时通告中携带该地址与本地接收端口作为定位器，其他节点（包括其他模拟器）据此发送 REDP
+    ImpairmentProfile impair;                            //!< 发送链路的损伤
+};
+
+/**
+ * @brief 节点模拟器
+ * @details 以一个线程按各自的相位为全部模拟节点周期发送 RNDP 通告；另一个线程监听 RNDP，记录外部节点（如检查器）
+ *          的定位器。此后各模拟节点在自己的相位上向其单播全部端点的 REDP，并按 `redp_refresh` 周期重发，以便在有损链路上
+ *          最终送达。REDP 随相位分散在一个周期内，不会因瞬时突发溢出对端的接收缓冲区。全部报文都经由同一条
+ *          `ImpairedLink` 发出
+ */
+class NodeSimulator
+{
+public:
+    explicit NodeSimulator(const SimOptions &opts) : opts(opts), link(opts.impair, opts.host), sink(0) {}
+    NodeSimulator(const NodeSimulator &) = delete;
+    NodeSimulator &operator=(const NodeSimulator &) = delete;
+    ~NodeSimulator() { stop(); }
+
+    void start()
+    {
+        running = true;
+        beacons = std::thread([this] { run_beacons(); });
+        listener = std::thread([this] { run_listener(); });
+        drain = std::thread([this] {
+            Datagram d;
+            while (running)
+                sink.recv(d);
+        });
+    }
+
+    void stop()
+    {
+        if (!running.exchange(false))
+            return;
+        beacons.join();
+        listener.join();
+        drain.join();
+    }
+
+    //! 第 `i` 个节点的 GUID 前缀
+    uint64_t prefix(size_t i) const
+    {
+        rm::lpss::Guid g;
+        g.fields.host = opts.host;
+        g.fields.pid = static_cast<uint16_t>(i);
+        g.fields.entity = 0;
+        return g.full & 0xFFFFFFFFFFFFULL;
+    }
+
+    //! 第 `i` 个节点的名称
+    std::string name(size_t i) const { return "sim_" + std::to_string(opts.host) + "_" + std::to_string(i); }
+
+    //! 已发现的对端数
+    size_t peers()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return targets.size();
+    }
+
+    //! 向 GUID 的 host 字段为 `host` 的对端发送的 REDP 数
+    uint64_t sent_to(uint32_t host)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        uint64_t n = 0;
+        for (auto &t : targets)
+            n += t.host == host ? t.sent : 0;
+        return n;
+    }
+
+    //! 发送链路的统计
+    ImpairedLink::Stats link_stats() { return link.snapshot(); }
+
+    const SimOptions &options() const { return opts; }
+
+private:
+    void run_beacons()
+    {
+        uint32_t group;
+        inet_pton(AF_INET, opts.group.c_str(), &group);
+        std::vector<std::string> beacon(opts.nodes);
+        for (size_t i = 0; i < opts.nodes; i++)
+        {
+            rm::lpss::RNDPMessage msg;
+            msg.guid.full = prefix(i);
+            msg.name = name(i);
+            if (!opts.locator_ip.empty())
+            {
+                rm::lpss::Locator loc{sink.port(), {}};
+                inet_pton(AF_INET, opts.locator_ip.c_str(), loc.ip.data());
+                msg.locators.push_back(loc);
+            }
+            beacon[i] = msg.serialize();
+        }
+        // 各节点的发送相位均匀分布在一个周期内
+        auto start = std::chrono::steady_clock::now();
+        uint64_t refresh = opts.redp_refresh.count() ? std::max<uint64_t>(opts.redp_refresh / std::max(opts.period, std::chrono::milliseconds(1)), 1) : 0;
+        auto step = std::chrono::duration_cast<std::chrono::microseconds>(opts.period) / std::max<size_t>(opts.nodes, 1);
+        for (uint64_t k = 0; running; k++)
+        {
+            std::this_thread::sleep_until(start + step * k);
+            size_t i = k % opts.nodes;
+            link.send(group, opts.port, beacon[i]);
+            // 节点在自己的相位上向对端发送 REDP：发现对端后的第一轮，以及此后每隔 refresh 轮
+            std::vector<std::pair<uint32_t, uint16_t>> due;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                round = k;
+                for (auto &t : targets)
+                {
+                    if (k < t.since)
+                        continue;
+                    uint64_t r = (k - t.since) / opts.nodes;
+                    if (r == 0 || (refresh && r % refresh == 0))
+                        due.emplace_back(t.addr, t.port), t.sent += opts.endpoints;
+                }
+            }
+            for (auto [addr, port] : due)
+                announce(i, addr, port);
+        }
+    }
+
+    void run_listener()
+    {
+        UdpReceiver sock(opts.port, opts.group);
+        Datagram d;
+        while (running)
+        {
+            if (!sock.recv(d) || d.data.size() < 14 || d.data[0] != 'N')
+                continue;
+            auto msg = rm::lpss::RNDPMessage::deserialize(d.data.data());
+            if (msg.guid.fields.host == opts.host || msg.locators.empty())
+                continue;
+            auto &loc = msg.locators.front();
+            uint32_t addr;
+            memcpy(&addr, loc.ip.data(), 4);
+            std::lock_guard<std::mutex> lock(mtx);
+            if (std::none_of(targets.begin(), targets.end(), [&](auto &t) { return t.addr == addr && t.port == loc.port; }))
+                targets.push_back({addr, loc.port, msg.guid.fields.host, round + 1});
+        }
+    }
+
+    //! 向对端单播第 `i` 个节点全部端点的 REDP
+    void announce(size_t i, uint32_t addr, uint16_t port)
+    {
+        for (size_t e = 0; e < opts.endpoints; e++)
+        {
+            rm::lpss::REDPMessage msg;
+            msg.action = rm::lpss::REDPMessage::Action::New;
+            msg.type = e % 2 ? rm::lpss::REDPMessage::Type::Reader : rm::lpss::REDPMessage::Type::Writer;
+            msg.endpoint_guid.full = prefix(i) | static_cast<uint64_t>(e + 1) << 48;
+            msg.topic = "/sim/topic_" + std::to_string((i * 7 + e) % std::max<size_t>(opts.topics, 1));
+            msg.msgtype = "StringMsg";
+            link.send(addr, port, msg.serialize());
+        }
+    }
+
+    struct Target
+    {
+        uint32_t addr;
+        uint16_t port;
+        uint32_t host;   //!< 对端 GUID 的 host 字段
+        uint64_t since;  //!< 发现对端后的第一个发送序号
+        uint64_t sent{}; //!< 已发送的 REDP 数
+    };
+
+    SimOptions opts;
+    ImpairedLink link;
+    std::atomic<bool> running{};
+    UdpReceiver sink; //!< 接收其他节点发来的 REDP，只丢弃
+    std::thread beacons, listener, drain;
+    std::mutex mtx;
+    std::vector<Target> targets;
+    uint64_t round{}; //!< 最近一次通告的发送序号
+};
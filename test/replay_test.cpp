@@ -0,0 +1,227 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "inspector.hpp"
+#include "udp_receiver.hpp"
+
+using namespace std::chrono_literals;
+
+static int failures = 0;
+
+//! 检查条件，失败时输出所在行并计数
+#define CHECK(cond)                                                       \
+    do                                                                    \
+    {                                                                     \
+        if (!(cond))                                                      \
+        {                                                                 \
+            printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond);      \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+//! 以当前虚拟时间注入一个节点的 RNDP 通告
+void announce(Inspector &inspector, uint64_t prefix, const char *name)
+{
+    rm::lpss::RNDPMessage msg;
+    msg.guid.full = prefix;
+    msg.name = name;
+    auto payload = msg.serialize();
+    Datagram dgram;
+    dgram.data = payload;
+    inspector.inject(dgram);
+}
+
+//! 以当前虚拟时间注入一个发布者端点的 REDP 通告
+void publish(Inspector &inspector, uint64_t prefix, uint16_t entity, const char *topic)
+{
+    rm::lpss::REDPMessage msg;
+    msg.action = rm::lpss::REDPMessage::Action::New;
+    msg.type = rm::lpss::REDPMessage::Type::Writer;
+    msg.endpoint_guid.full = prefix | static_cast<uint64_t>(entity) << 48;
+    msg.topic = topic;
+    msg.msgtype = "StringMsg";
+    auto payload = msg.serialize();
+    Datagram dgram;
+    dgram.data = payload;
+    inspector.inject(dgram);
+}
+
+//! 节点的状态：0 表示不存在，1 表示在线，2 表示因抖动抑制而保留
+int node_state(Inspector &inspector, uint64_t prefix)
+{
+    auto &state = inspector.state();
+    std::lock_guard<std::mutex> lock(state.mtx);
+    auto it = state.nodes.find(prefix);
+    return it == state.nodes.end() ? 0 : it->second.held ? 2 : 1;
+}
+
+int main()
+{
+    Clock::use_virtual();
+    InspectorOptions opts;
+    opts.offline = true;
+    Inspector inspector(opts);
+    std::vector<std::pair<TopologyEvent::Kind, uint64_t>> events;
+    inspector.subscribe([&](const TopologyEvent &ev) {
+        if (ev.kind == TopologyEvent::Kind::NodeUp || ev.kind == TopologyEvent::Kind::NodeDown)
+            events.emplace_back(ev.kind, ev.prefix);
+    });
+    std::string err;
+    if (!inspector.start(&err))
+    {
+        printf("Failed to start inspector: %s\n", err.c_str());
+        return 1;
+    }
+    // 等心跳线程完成首个节拍，此后每推进 1 s 恰好执行一次超时清理与历史采样
+    Clock::advance(0s);
+
+    // 1. 超时：最后一次通告后满 NODE_TTL 仍保留，下一个节拍移除
+    constexpr uint64_t CAM = 0xA1;
+    announce(inspector, CAM, "cam");
+    CHECK(node_state(inspector, CAM) == 1);
+    Clock::advance(NODE_TTL);
+    CHECK(node_state(inspector, CAM) == 1);
+    Clock::advance(1s);
+    CHECK(node_state(inspector, CAM) == 0);
+
+    // 2. 抖动抑制：第 3 次超时时惩罚值 1000 + 1000 * 2^(-6/30) 再经 6 s 衰减后加 1000，约 2628，超过抑制阈值 2000，
+    //    节点被保留；惩罚值衰减至 750 以下需约 54.3 s，因此 54 s 后仍保留、55 s 后移除
+    constexpr uint64_t LIDAR = 0xB1;
+    events.clear();
+    for (int flap = 1; flap <= 3; flap++)
+    {
+        announce(inspector, LIDAR, "lidar");
+        Clock::advance(NODE_TTL + 1s);
+        CHECK(node_state(inspector, LIDAR) == (flap < 3 ? 0 : 2));
+    }
+    Clock::advance(54s);
+    CHECK(node_state(inspector, LIDAR) == 2);
+    Clock::advance(1s);
+    CHECK(node_state(inspector, LIDAR) == 0);
+    // 每次上线与下线各发布一次，被保留的节点在最终移除时不再重复发布下线事件
+    CHECK(events.size() == 6);
+    for (size_t i = 0; i < events.size(); i++)
+        CHECK(events[i].first == (i % 2 ? TopologyEvent::Kind::NodeDown : TopologyEvent::Kind::NodeUp) &&
+              events[i].second == LIDAR);
+
+    // 3. 历史采样：节点每秒通告一次，持续 120 s，1 s 分辨率每个节拍一个采样，1 min 分辨率每 60 个采样一个
+    constexpr uint64_t RADAR = 0xC1;
+    publish(inspector, RADAR, 1, "/radar/points");
+    for (int i = 0; i < 120; i++)
+    {
+        announce(inspector, RADAR, "radar");
+        Clock::advance(1s);
+    }
+    {
+        auto &state = inspector.state();
+        std::lock_guard<std::mutex> lock(state.mtx);
+        auto &node = state.nodes.at(RADAR);
+        CHECK(node.history != nullptr);
+        if (node.history)
+        {
+            CHECK(node.history->rate.recent(0, 1000).size() == 120);
+            CHECK(node.history->rate.recent(1, 1000).size() == 2);
+            auto rate = node.history->rate.recent(0, 1);
+            CHECK(rate.size() == 1 && rate[0] == 1.0f);
+            auto eps = node.history->endpoints.recent(0, 1);
+            CHECK(eps.size() == 1 && eps[0] == 1.0f);
+        }
+        auto topic = state.topic_history.find(state.names.lookup("/radar/points"));
+        CHECK(topic != state.topic_history.end());
+        if (topic != state.topic_history.end())
+        {
+            CHECK(topic->second.pubs.recent(0, 1000).size() == 120);
+            auto pubs = topic->second.pubs.recent(0, 1);
+            CHECK(pubs.size() == 1 && pubs[0] == 1.0f);
+        }
+    }
+
+    // 4. 重启：新 GUID 先上线，旧 GUID 错过预期通告后才下线；同名同址的两个存活节点均保留其端点
+    constexpr uint64_t GPS = 0xE1, GPS_RESTARTED = 0xE2;
+    for (int i = 0; i < 5; i++)
+    {
+        announce(inspector, GPS, "gps");
+        Clock::advance(1s);
+    }
+    events.clear();
+    announce(inspector, GPS_RESTARTED, "gps");
+    CHECK(node_state(inspector, GPS) == 1 && node_state(inspector, GPS_RESTARTED) == 1);
+    Clock::advance(1s);
+    announce(inspector, GPS_RESTARTED, "gps");
+    Clock::advance(1s);
+    CHECK(node_state(inspector, GPS) == 0 && node_state(inspector, GPS_RESTARTED) == 1);
+    CHECK(events.size() == 2);
+    if (events.size() == 2)
+        CHECK(events[0].first == TopologyEvent::Kind::NodeUp && events[0].second == GPS_RESTARTED &&
+              events[1].first == TopologyEvent::Kind::NodeDown && events[1].second == GPS);
+
+    constexpr uint64_t IMU_A = 0xF1, IMU_B = 0xF2;
+    announce(inspector, IMU_A, "imu");
+    publish(inspector, IMU_A, 1, "/imu/data");
+    announce(inspector, IMU_B, "imu");
+    announce(inspector, IMU_A, "imu");
+    announce(inspector, IMU_B, "imu");
+    Clock::advance(2s);
+    announce(inspector, IMU_A, "imu");
+    announce(inspector, IMU_B, "imu");
+    CHECK(node_state(inspector, IMU_A) == 1 && node_state(inspector, IMU_B) == 1);
+    {
+        auto &state = inspector.state();
+        std::lock_guard<std::mutex> lock(state.mtx);
+        auto eps = state.topics.find(IMU_A);
+        CHECK(eps != state.topics.end() && eps->second.size() == 1);
+    }
+
+    // 5. 心跳统计：第 2 个报文是重复报文时周期估计不受影响，健康节点不会被判为丢包
+    constexpr uint64_t SONAR = 0xF3;
+    announce(inspector, SONAR, "sonar");
+    announce(inspector, SONAR, "sonar");
+    for (int i = 0; i < 60; i++)
+    {
+        Clock::advance(1s);
+        announce(inspector, SONAR, "sonar");
+        if (i % 10 == 0)
+            announce(inspector, SONAR, "sonar");
+    }
+    {
+        auto &state = inspector.state();
+        std::lock_guard<std::mutex> lock(state.mtx);
+        auto &hb = state.nodes.at(SONAR).hb;
+        CHECK(hb.period > 0.99 && hb.period < 1.01);
+        CHECK(hb.missed == 0 && hb.loss == 0);
+    }
+
+    inspector.stop();
+
+    // 6. 内存预算：预算小到新节点本身即为淘汰对象时，通告处理完毕后节点已被淘汰，统计照常计入全网
+    {
+        InspectorOptions capped_opts;
+        capped_opts.offline = true;
+        capped_opts.mem_cap = 1;
+        Inspector capped(capped_opts);
+        if (!capped.start(&err))
+        {
+            printf("Failed to start inspector: %s\n", err.c_str());
+            return 1;
+        }
+        constexpr uint64_t IMU = 0xD1;
+        announce(capped, IMU, "imu");
+        CHECK(node_state(capped, IMU) == 0);
+        auto &state = capped.state();
+        {
+            std::lock_guard<std::mutex> lock(state.mtx);
+            CHECK(state.evicted_nodes == 1);
+            CHECK(state.columns.size() == 0);
+        }
+        capped.stop();
+    }
+
+    if (failures)
+    {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}